@@ -0,0 +1,175 @@
+// Tests for the display code, run against the emulated TFT in host/
+
+// g++ -std=c++14 -Ihost display_test.cpp moulick/display.cpp -o dt
+
+#include <cassert>
+#include <iostream>
+
+#include <Elegoo_TFTLCD.h>
+
+#include "moulick/display.h"
+
+using namespace display;
+
+// The original fractional_bresenham, one drawPixel per pixel, with float
+// math (double here, so it is exact for a Q16 f)
+void reference_bresenham( int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                          double f, uint16_t color, Elegoo_TFTLCD *tft )
+{
+    int16_t dx    =  abs( x1 - x0 ), sx = x0 < x1 ? 1 : -1,
+            dy    = -abs( y1 - y0 ), sy = y0 < y1 ? 1 : -1,
+            err   = dx + dy, e2,
+            x_end = x0 + ( x1 - x0 ) * f,
+            y_end = y0 + ( y1 - y0 ) * f;
+    bool shallow = dx > -dy;
+    for (;;)
+    {
+        tft->drawPixel( x0, y0, color );
+        if( shallow )  { if( x0 == x_end ) break; }
+                 else  { if( y0 == y_end ) break; }
+        e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x0 += sx; }
+        if (e2 <= dx) { err += dx; y0 += sy; }
+    }
+}
+
+// Draw the same line both ways and compare every pixel
+void check_line( int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint32_t f16,
+                 Elegoo_TFTLCD& a, Elegoo_TFTLCD& b )
+{
+    a.fillScreen( BLACK );
+    b.fillScreen( BLACK );
+    a.clear_costs();
+    b.clear_costs();
+    fractional_bresenham( x0, y0, x1, y1, f16, RED, &a );
+    reference_bresenham( x0, y0, x1, y1, f16 / 65536.0, RED, &b );
+    assert( a.framebuffer == b.framebuffer );
+    assert( a.total().pixels == b.total().pixels );  // no pixel drawn twice
+    assert( a.total().bus_writes <= b.total().bus_writes );
+}
+
+void test_fractional_bresenham()
+{
+    Elegoo_TFTLCD a, b;
+    a.setRotation( 1 );
+    b.setRotation( 1 );
+
+    // Every radial line of the chart, at a range of fractions
+    uint64_t span_writes = 0, pixel_writes = 0;
+    for( int slot = 0; slot < CHART_N; slot++ )
+    {
+        float theta = D_THETA * slot,
+              st = sin( theta ),
+              ct = cos( theta );
+        int x0 = CHART_X + CHART_R0 * st,
+            y0 = CHART_Y - CHART_R0 * ct,
+            x1 = CHART_X + ( CHART_R0 + CHART_DR ) * st,
+            y1 = CHART_Y - ( CHART_R0 + CHART_DR ) * ct;
+        for( uint32_t i = 0; i <= 40; i++ )
+        {
+            check_line( x0, y0, x1, y1, i * q16_one / 40, a, b );
+            span_writes += a.total().bus_writes;
+            pixel_writes += b.total().bus_writes;
+        }
+    }
+    assert( span_writes < pixel_writes * 3 / 4 );
+
+    // Straight, diagonal and steep lines in every direction
+    int16_t ends[][ 2 ] = { { 40, 0 }, { 0, 40 }, { 40, 40 }, { 40, 7 }, { 7, 40 }, { 40, 21 } };
+    for( auto& e : ends )
+        for( int sx = -1; sx <= 1; sx += 2 )
+            for( int sy = -1; sy <= 1; sy += 2 )
+                for( uint32_t f16 = 0; f16 <= q16_one; f16 += 331 )
+                    check_line( 160, 120, 160 + sx * e[ 0 ], 120 + sy * e[ 1 ], f16, a, b );
+
+    // A purely horizontal line is a single fast line
+    a.clear_costs();
+    fractional_bresenham( 10, 10, 50, 10, q16_one, RED, &a );
+    assert( a.total().calls == 1 && a.total().windows == 1 );
+
+    std::cout << "Fractional Bresenham test passed" << std::endl;
+}
+
+// The chart as it used to be drawn: erase the whole bar, then draw it
+void reference_bar( int slot, double f, uint16_t color, Elegoo_TFTLCD *tft )
+{
+    float theta = D_THETA * slot,
+          st = sin( theta ),
+          ct = cos( theta );
+    int x0 = CHART_X + CHART_R0 * st,
+        y0 = CHART_Y - CHART_R0 * ct,
+        x1 = CHART_X + ( CHART_R0 + CHART_DR ) * st,
+        y1 = CHART_Y - ( CHART_R0 + CHART_DR ) * ct;
+    reference_bresenham( x0, y0, x1, y1, 1.0, BACKGROUND, tft );
+    reference_bresenham( x0, y0, x1, y1, f, color, tft );
+}
+
+void test_delta_bars()
+{
+    Elegoo_TFTLCD a, b;
+    a.setRotation( 1 );
+    b.setRotation( 1 );
+    RadialChart chart, reference;
+    chart.init( &a );
+    reference.init( &b );  // Just for the base circle
+    a.clear_costs();
+
+    // Bars that grow, shrink and change color, in a few slots
+    uint16_t colors[] = { CHART_LINE_COL, CHART_PRIME_COL, CHART_TWIN_PRIME_COL,
+                          CHART_PALINDROMIC_PRIME_COL, CHART_TWIN_AND_PALINDROMIC_PRIME_COL };
+    uint32_t seed = 1;
+    for( int i = 0; i < 5000; i++ )
+    {
+        seed = seed * 1664525UL + 1013904223UL;
+        int slot = ( seed >> 8 ) % 7 * 37 % CHART_N,
+            t = ( seed >> 16 ) % 5;
+        if( t && ( seed >> 20 ) % 4 ) t = 0;  // mostly composites, like the real thing
+        uint32_t f16 = ( ( seed >> 24 ) % 101 ) * q16_one / 100;
+        chart.radial_line( slot, f16, t );
+        reference_bar( slot, f16 / 65536.0, colors[ t ], &b );
+        assert( a.framebuffer == b.framebuffer );
+    }
+
+    // A bar that grows a little only costs the new pixels
+    chart.radial_line( 0, q16_one / 2, 0 );
+    a.clear_costs();
+    chart.radial_line( 0, q16_one * 11 / 20, 0 );
+    assert( a.total().pixels == 2 );
+    a.clear_costs();
+    chart.radial_line( 0, q16_one * 11 / 20, 0 );
+    assert( a.total().pixels == 0 );
+
+    std::cout << "Delta bar test passed" << std::endl;
+}
+
+void test_chart_geometry()
+{
+    // The tables agree with the float trig they replace
+    for( int slot = 0; slot < CHART_N; slot++ )
+    {
+        float theta = D_THETA * (float) slot,
+              st = sin( theta ),
+              ct = cos( theta );
+        SpokeEnds b = read_spoke( ChartGeometry<>::bar, slot ),
+                  c = read_spoke( ChartGeometry<>::cursor, slot );
+        assert( CHART_X + b.x0 == (int) ( CHART_X + CHART_R0 * st ) );
+        assert( CHART_Y + b.y0 == (int) ( CHART_Y - CHART_R0 * ct ) );
+        assert( CHART_X + b.x1 == (int) ( CHART_X + ( CHART_R0 + CHART_DR ) * st ) );
+        assert( CHART_Y + b.y1 == (int) ( CHART_Y - ( CHART_R0 + CHART_DR ) * ct ) );
+        assert( CHART_X + c.x0 == (int) ( CHART_X + CHART_BASE_R0 * st ) );
+        assert( CHART_Y + c.y0 == (int) ( CHART_Y - CHART_BASE_R0 * ct ) );
+        assert( CHART_X + c.x1 == (int) ( CHART_X + CHART_BASE_R1 * st ) );
+        assert( CHART_Y + c.y1 == (int) ( CHART_Y - CHART_BASE_R1 * ct ) );
+    }
+    static_assert( const_sin( M_PI / 6 ) > 0.4999999 && const_sin( M_PI / 6 ) < 0.5000001, "sin" );
+    static_assert( const_cos( M_PI ) < -0.9999999, "cos" );
+
+    std::cout << "Chart geometry test passed" << std::endl;
+}
+
+int main()
+{
+    test_fractional_bresenham();
+    test_delta_bars();
+    test_chart_geometry();
+}
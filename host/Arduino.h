@@ -0,0 +1,22 @@
+/*
+  The bits of the Arduino core the display code leans on, so it compiles
+  on the host against the emulated TFT (see Elegoo_TFTLCD.h).
+*/
+#ifndef _HOST_ARDUINO_H_
+#define _HOST_ARDUINO_H_
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t byte;
+
+// A function rather than the Arduino macro, but it mixes types the same way
+template <typename A, typename B>
+inline auto min( A a, B b ) -> decltype( a < b ? a : b ) { return a < b ? a : b; }
+
+template <typename A, typename B>
+inline auto max( A a, B b ) -> decltype( a > b ? a : b ) { return a > b ? a : b; }
+
+#endif // _HOST_ARDUINO_H_
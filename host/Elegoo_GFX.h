@@ -0,0 +1,217 @@
+/*
+  Host stand-in for the Elegoo (Adafruit) GFX core, for the primitives the
+  display code uses. The shapes are decomposed the way the real library
+  does it (lines into pixels or fast H/V lines, circles into vertical
+  spans, text into pixels or size x size rects) so the per-primitive costs
+  counted by Elegoo_TFTLCD match what goes over the bus on the device.
+
+  Font: the digits are the library's 5x7 glyphs. Everything else gets a
+  stand-in glyph with a similar number of lit pixels, which is good enough
+  for costs but won't look right.
+*/
+#ifndef _HOST_ELEGOO_GFX_H_
+#define _HOST_ELEGOO_GFX_H_
+
+#include "Arduino.h"
+
+namespace host_gfx {
+
+  const uint8_t digit_glyphs[ 10 ][ 5 ] = {
+    { 0x3E, 0x51, 0x49, 0x45, 0x3E },  // 0
+    { 0x00, 0x42, 0x7F, 0x40, 0x00 },  // 1
+    { 0x72, 0x49, 0x49, 0x49, 0x46 },  // 2
+    { 0x21, 0x41, 0x49, 0x4D, 0x33 },  // 3
+    { 0x18, 0x14, 0x12, 0x7F, 0x10 },  // 4
+    { 0x27, 0x45, 0x45, 0x45, 0x39 },  // 5
+    { 0x3C, 0x4A, 0x49, 0x49, 0x31 },  // 6
+    { 0x41, 0x21, 0x11, 0x09, 0x07 },  // 7
+    { 0x36, 0x49, 0x49, 0x49, 0x36 },  // 8
+    { 0x46, 0x49, 0x49, 0x29, 0x1E }   // 9
+  };
+
+  const uint8_t other_glyph[ 5 ] = { 0x38, 0x44, 0x44, 0x44, 0x38 };  // ~ 'o'
+
+  inline const uint8_t* glyph( unsigned char c )
+  {
+    static const uint8_t blank[ 5 ] = { 0, 0, 0, 0, 0 };
+    if( c >= '0' && c <= '9' ) return digit_glyphs[ c - '0' ];
+    if( c == ' ' ) return blank;
+    return other_glyph;
+  }
+
+}
+
+class Elegoo_GFX
+{
+public:
+  Elegoo_GFX( int16_t w, int16_t h )
+    : WIDTH( w ), HEIGHT( h ), _width( w ), _height( h ),
+      cursor_x( 0 ), cursor_y( 0 ), textcolor( 0xFFFF ), textbgcolor( 0xFFFF ),
+      textsize( 1 ), rotation( 0 ), wrap( true ) {}
+
+  virtual ~Elegoo_GFX() {}
+
+  // The display has to provide this one, the rest have fallbacks
+  virtual void drawPixel( int16_t x, int16_t y, uint16_t color ) = 0;
+
+  virtual void drawFastVLine( int16_t x, int16_t y, int16_t h, uint16_t color )
+  {
+    for( int16_t i = 0; i < h; i++ ) drawPixel( x, y + i, color );
+  }
+
+  virtual void drawFastHLine( int16_t x, int16_t y, int16_t w, uint16_t color )
+  {
+    for( int16_t i = 0; i < w; i++ ) drawPixel( x + i, y, color );
+  }
+
+  virtual void fillRect( int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color )
+  {
+    for( int16_t i = 0; i < w; i++ ) drawFastVLine( x + i, y, h, color );
+  }
+
+  virtual void fillScreen( uint16_t color ) { fillRect( 0, 0, _width, _height, color ); }
+
+  // Bresenham, with the straight cases handed to the fast lines
+  virtual void drawLine( int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color )
+  {
+    if( x0 == x1 )
+    {
+      if( y0 > y1 ) swap( y0, y1 );
+      drawFastVLine( x0, y0, y1 - y0 + 1, color );
+      return;
+    }
+    if( y0 == y1 )
+    {
+      if( x0 > x1 ) swap( x0, x1 );
+      drawFastHLine( x0, y0, x1 - x0 + 1, color );
+      return;
+    }
+
+    bool steep = abs( y1 - y0 ) > abs( x1 - x0 );
+    if( steep ) { swap( x0, y0 ); swap( x1, y1 ); }
+    if( x0 > x1 ) { swap( x0, x1 ); swap( y0, y1 ); }
+
+    int16_t dx = x1 - x0,
+            dy = abs( y1 - y0 ),
+            err = dx / 2,
+            ystep = y0 < y1 ? 1 : -1;
+    for( ; x0 <= x1; x0++ )
+    {
+      if( steep ) drawPixel( y0, x0, color );
+      else        drawPixel( x0, y0, color );
+      err -= dy;
+      if( err < 0 ) { y0 += ystep; err += dx; }
+    }
+  }
+
+  void fillCircle( int16_t x0, int16_t y0, int16_t r, uint16_t color )
+  {
+    drawFastVLine( x0, y0 - r, 2 * r + 1, color );
+    fillCircleHelper( x0, y0, r, 3, 0, color );
+  }
+
+  void fillCircleHelper( int16_t x0, int16_t y0, int16_t r, uint8_t corners, int16_t delta, uint16_t color )
+  {
+    int16_t f = 1 - r, ddF_x = 1, ddF_y = -2 * r,
+            x = 0, y = r, px = x, py = y;
+    delta++;
+    while( x < y )
+    {
+      if( f >= 0 ) { y--; ddF_y += 2; f += ddF_y; }
+      x++; ddF_x += 2; f += ddF_x;
+      if( x < y + 1 )
+      {
+        if( corners & 1 ) drawFastVLine( x0 + x, y0 - y, 2 * y + delta, color );
+        if( corners & 2 ) drawFastVLine( x0 - x, y0 - y, 2 * y + delta, color );
+      }
+      if( y != py )
+      {
+        if( corners & 1 ) drawFastVLine( x0 + py, y0 - px, 2 * px + delta, color );
+        if( corners & 2 ) drawFastVLine( x0 - py, y0 - px, 2 * px + delta, color );
+        py = y;
+      }
+      px = x;
+    }
+  }
+
+  // Transparent background when bg == color, as setTextColor( c ) does
+  virtual void drawChar( int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size )
+  {
+    const uint8_t *g = host_gfx::glyph( c );
+    for( int8_t i = 0; i < 6; i++ )
+    {
+      uint8_t line = i == 5 ? 0 : g[ i ];
+      for( int8_t j = 0; j < 8; j++, line >>= 1 )
+      {
+        if( line & 1 )
+        {
+          if( size == 1 ) drawPixel( x + i, y + j, color );
+          else fillRect( x + i * size, y + j * size, size, size, color );
+        }
+        else if( bg != color )
+        {
+          if( size == 1 ) drawPixel( x + i, y + j, bg );
+          else fillRect( x + i * size, y + j * size, size, size, bg );
+        }
+      }
+    }
+  }
+
+  size_t write( uint8_t c )
+  {
+    if( c == '\n' )
+    {
+      cursor_y += textsize * 8;
+      cursor_x = 0;
+    }
+    else if( c != '\r' )
+    {
+      drawChar( cursor_x, cursor_y, c, textcolor, textbgcolor, textsize );
+      cursor_x += textsize * 6;
+      if( wrap && cursor_x > _width - textsize * 6 )
+      {
+        cursor_y += textsize * 8;
+        cursor_x = 0;
+      }
+    }
+    return 1;
+  }
+
+  size_t print( char c ) { return write( c ); }
+
+  size_t print( const char* s )
+  {
+    size_t n = 0;
+    while( *s ) n += write( *s++ );
+    return n;
+  }
+
+  void setCursor( int16_t x, int16_t y ) { cursor_x = x; cursor_y = y; }
+  void setTextSize( uint8_t s ) { textsize = s > 0 ? s : 1; }
+  void setTextColor( uint16_t c ) { textcolor = textbgcolor = c; }
+  void setTextColor( uint16_t c, uint16_t bg ) { textcolor = c; textbgcolor = bg; }
+  void setTextWrap( bool w ) { wrap = w; }
+
+  virtual void setRotation( uint8_t r )
+  {
+    rotation = r & 3;
+    _width = ( rotation & 1 ) ? HEIGHT : WIDTH;
+    _height = ( rotation & 1 ) ? WIDTH : HEIGHT;
+  }
+
+  int16_t width() const { return _width; }
+  int16_t height() const { return _height; }
+  uint8_t getRotation() const { return rotation; }
+
+protected:
+  const int16_t WIDTH, HEIGHT;
+  int16_t _width, _height,
+          cursor_x, cursor_y;
+  uint16_t textcolor, textbgcolor;
+  uint8_t textsize, rotation;
+  bool wrap;
+
+  static void swap( int16_t& a, int16_t& b ) { int16_t t = a; a = b; b = t; }
+};
+
+#endif // _HOST_ELEGOO_GFX_H_
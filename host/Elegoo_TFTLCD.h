@@ -0,0 +1,223 @@
+/*
+  Host stand-in for the Elegoo ILI9341 driver. It draws into an RGB565
+  framebuffer and counts what the real thing would cost.
+
+  Bus model (8 bit parallel, as the Elegoo library drives the 9341): every
+  byte is one write strobe. Setting the address window is CASET + 4 bytes
+  and PASET + 4 bytes. Pixels then go out as RAMWR + 2 bytes per pixel. So
+  a lone drawPixel is 13 writes, while an n pixel fast line or rect is
+  11 + 2n.
+
+  Costs are kept per primitive (the outermost call, so a drawLine's pixels
+  are billed to drawLine) and per section. Set the section with a
+  DrawSection around the code you want to measure.
+*/
+#ifndef _HOST_ELEGOO_TFTLCD_H_
+#define _HOST_ELEGOO_TFTLCD_H_
+
+#include <stdio.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Elegoo_GFX.h"
+
+struct DrawCost
+{
+  uint64_t calls = 0,       // public API calls
+           pixels = 0,      // pixels written
+           windows = 0,     // address window changes
+           bus_writes = 0;  // write strobes
+
+  void operator+=( const DrawCost& c )
+  {
+    calls += c.calls; pixels += c.pixels; windows += c.windows; bus_writes += c.bus_writes;
+  }
+};
+
+class Elegoo_TFTLCD : public Elegoo_GFX
+{
+public:
+  static const int16_t TFTWIDTH = 240,
+                       TFTHEIGHT = 320;
+
+  std::vector<uint16_t> framebuffer;  // _width x _height, row major
+  std::map<std::string, DrawCost> by_primitive, by_section;
+  const char *section;
+
+  Elegoo_TFTLCD( uint8_t /* cs */ = 0, uint8_t /* cd */ = 0, uint8_t /* wr */ = 0, uint8_t /* rd */ = 0, uint8_t /* reset */ = 0 )
+    : Elegoo_GFX( TFTWIDTH, TFTHEIGHT ), framebuffer( TFTWIDTH * TFTHEIGHT, 0 ),
+      section( "(none)" ), depth( 0 ), primitive( nullptr ) {}
+
+  void reset() {}
+  void begin( uint16_t /* id */ = 0x9341 ) {}
+
+  void setRotation( uint8_t r ) override
+  {
+    Elegoo_GFX::setRotation( r );
+    framebuffer.assign( framebuffer.size(), 0 );
+  }
+
+  uint16_t pixel( int16_t x, int16_t y ) const { return framebuffer[ y * _width + x ]; }
+
+  void clear_costs()
+  {
+    by_primitive.clear();
+    by_section.clear();
+  }
+
+  DrawCost total() const
+  {
+    DrawCost t;
+    for( const auto& c : by_section ) t += c.second;
+    return t;
+  }
+
+  // Binary PPM, for eyeballing
+  bool save_ppm( const char* path ) const
+  {
+    FILE *f = fopen( path, "wb" );
+    if( !f ) return false;
+    fprintf( f, "P6\n%d %d\n255\n", _width, _height );
+    for( uint16_t c : framebuffer )
+    {
+      uint8_t rgb[ 3 ] = { (uint8_t) ( ( c >> 11 ) << 3 ), (uint8_t) ( ( ( c >> 5 ) & 0x3F ) << 2 ), (uint8_t) ( ( c & 0x1F ) << 3 ) };
+      fwrite( rgb, 1, 3, f );
+    }
+    fclose( f );
+    return true;
+  }
+
+  // --- The primitives the real driver implements itself ---
+
+  void drawPixel( int16_t x, int16_t y, uint16_t color ) override
+  {
+    Call c( this, "drawPixel" );
+    if( x < 0 || y < 0 || x >= _width || y >= _height ) return;
+    set_window( x, y, x, y );
+    flood( x, y, 1, 1, color );
+  }
+
+  void drawFastHLine( int16_t x, int16_t y, int16_t w, uint16_t color ) override
+  {
+    Call c( this, "drawFastHLine" );
+    fill( x, y, w, 1, color );
+  }
+
+  void drawFastVLine( int16_t x, int16_t y, int16_t h, uint16_t color ) override
+  {
+    Call c( this, "drawFastVLine" );
+    fill( x, y, 1, h, color );
+  }
+
+  void fillRect( int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color ) override
+  {
+    Call c( this, "fillRect" );
+    fill( x, y, w, h, color );
+  }
+
+  void fillScreen( uint16_t color ) override
+  {
+    Call c( this, "fillScreen" );
+    fill( 0, 0, _width, _height, color );
+  }
+
+  // --- Composite ones, only here so the cost goes to the right name ---
+
+  void drawLine( int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color ) override
+  {
+    Call c( this, "drawLine" );
+    Elegoo_GFX::drawLine( x0, y0, x1, y1, color );
+  }
+
+  void drawChar( int16_t x, int16_t y, unsigned char ch, uint16_t color, uint16_t bg, uint8_t size ) override
+  {
+    Call c( this, "drawChar" );
+    Elegoo_GFX::drawChar( x, y, ch, color, bg, size );
+  }
+
+  void fillCircle( int16_t x0, int16_t y0, int16_t r, uint16_t color )
+  {
+    Call c( this, "fillCircle" );
+    Elegoo_GFX::fillCircle( x0, y0, r, color );
+  }
+
+private:
+  int depth;
+  const char *primitive;  // the outermost call in progress
+
+  struct Call
+  {
+    Elegoo_TFTLCD *t;
+    Call( Elegoo_TFTLCD *_t, const char* name ) : t( _t )
+    {
+      if( t->depth++ == 0 )
+      {
+        t->primitive = name;
+        DrawCost d;
+        d.calls = 1;
+        t->charge( d );
+      }
+    }
+    ~Call() { t->depth--; }
+  };
+
+  void charge( const DrawCost& d )
+  {
+    by_primitive[ primitive ] += d;
+    by_section[ section ] += d;
+  }
+
+  void set_window( int16_t /* x0 */, int16_t /* y0 */, int16_t /* x1 */, int16_t /* y1 */ )
+  {
+    DrawCost d;
+    d.windows = 1;
+    d.bus_writes = 10;  // CASET + 4, PASET + 4
+    charge( d );
+  }
+
+  void flood( int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color )
+  {
+    for( int16_t j = y; j < y + h; j++ )
+      for( int16_t i = x; i < x + w; i++ )
+        framebuffer[ j * _width + i ] = color;
+    DrawCost d;
+    d.pixels = (uint64_t) w * h;
+    d.bus_writes = 1 + 2 * d.pixels;  // RAMWR + 2 bytes a pixel
+    charge( d );
+  }
+
+  // Clip, set the window, flood
+  void fill( int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color )
+  {
+    int16_t x2 = x + w - 1,
+            y2 = y + h - 1;
+    if( w <= 0 || h <= 0 || x >= _width || y >= _height || x2 < 0 || y2 < 0 ) return;
+    if( x < 0 ) x = 0;
+    if( y < 0 ) y = 0;
+    if( x2 >= _width ) x2 = _width - 1;
+    if( y2 >= _height ) y2 = _height - 1;
+    set_window( x, y, x2, y2 );
+    flood( x, y, x2 - x + 1, y2 - y + 1, color );
+  }
+};
+
+/*
+  Bills everything drawn while it is alive to a named section, e.g.
+
+    { DrawSection s( tft, "Clock::draw" ); clock.draw(); }
+*/
+struct DrawSection
+{
+  Elegoo_TFTLCD *tft;
+  const char *previous;
+
+  DrawSection( Elegoo_TFTLCD *_tft, const char* name ) : tft( _tft ), previous( _tft->section )
+  {
+    tft->section = name;
+  }
+  ~DrawSection() { tft->section = previous; }
+};
+
+#endif // _HOST_ELEGOO_TFTLCD_H_
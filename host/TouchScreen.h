@@ -0,0 +1,23 @@
+/*
+  Host stand-in for the Adafruit/Elegoo TouchScreen library. Only TSPoint,
+  so the touch handling that doesn't talk to the pins (debounce.h) can be
+  fed scripted points in tests.
+*/
+#ifndef _HOST_TOUCHSCREEN_H_
+#define _HOST_TOUCHSCREEN_H_
+
+#include <stdint.h>
+
+class TSPoint
+{
+public:
+  TSPoint() : x( 0 ), y( 0 ), z( 0 ) {}
+  TSPoint( int16_t _x, int16_t _y, int16_t _z ) : x( _x ), y( _y ), z( _z ) {}
+
+  bool operator==( TSPoint p ) const { return p.x == x && p.y == y && p.z == z; }
+  bool operator!=( TSPoint p ) const { return !( *this == p ); }
+
+  int16_t x, y, z;
+};
+
+#endif // _HOST_TOUCHSCREEN_H_
@@ -0,0 +1,80 @@
+/*
+  Runs the device display code against the emulated TFT and reports what
+  each part of it costs on the bus.
+
+  Prints JSON lines: one per section (switching screens, Clock::draw,
+  Clock::partial_draw, Stats::draw) and one per primitive.
+
+  g++ -std=c++14 -O2 -Ihost host/display_harness.cpp moulick/display.cpp -o dh
+  ./dh [steps] [start m] [frame.ppm]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <Elegoo_TFTLCD.h>
+
+#include "../moulick/display.h"
+
+using namespace display;
+
+std::map<std::string, uint64_t> runs;  // how many times each section ran
+
+template <typename F>
+void run( Elegoo_TFTLCD& tft, const char* name, F f )
+{
+  DrawSection s( &tft, name );
+  runs[ name ]++;
+  f();
+}
+
+void report( const char* kind, const std::string& name, const DrawCost& c, uint64_t n )
+{
+  printf( "{\"%s\": \"%s\", \"runs\": %llu, \"calls\": %llu, \"pixels\": %llu, "
+          "\"windows\": %llu, \"bus_writes\": %llu",
+          kind, name.c_str(), (unsigned long long) n, (unsigned long long) c.calls,
+          (unsigned long long) c.pixels, (unsigned long long) c.windows,
+          (unsigned long long) c.bus_writes );
+  if( n ) printf( ", \"bus_writes_per_run\": %.1f", (double) c.bus_writes / n );
+  printf( "}\n" );
+}
+
+int main( int argc, char** argv )
+{
+  unsigned long steps = argc > 1 ? strtoul( argv[ 1 ], nullptr, 10 ) : 2000;
+  prime_t start = argc > 2 ? strtoul( argv[ 2 ], nullptr, 10 ) : 1000000;
+
+  Elegoo_TFTLCD tft;
+  tft.reset();
+  tft.begin( TFT_ID );
+  tft.setRotation( 1 );
+
+  PrimeClock pc;
+  pc.restart_clock_from( start );
+  Clock clock;
+  Stats stats;
+
+  run( tft, "switch_to(Corona)", [ & ] { clock.init( &tft, &pc ); } );
+  for( unsigned long i = 0; i < steps; i++ )
+  {
+    pc.check_next();
+    // What the scheduler's partial redraw would have drawn half way through the test
+    prime_t k = pc.pt.k;
+    pc.pt.k = pc.pt.k_max / 2 + 1;
+    run( tft, "Clock::partial_draw", [ & ] { clock.partial_draw(); } );
+    pc.pt.k = k;
+    run( tft, "Clock::draw", [ & ] { clock.draw(); } );
+  }
+  if( argc > 3 ) tft.save_ppm( argv[ 3 ] );
+
+  run( tft, "switch_to(Stats)", [ & ] { stats.init( &tft, &pc ); } );
+  for( unsigned long i = 0; i < steps; i++ )
+  {
+    pc.check_next();
+    run( tft, "Stats::draw", [ & ] { stats.draw(); } );
+  }
+
+  for( const auto& s : tft.by_section )
+    if( runs.count( s.first ) ) report( "section", s.first, s.second, runs[ s.first ] );
+  for( const auto& p : tft.by_primitive )
+    report( "primitive", p.first, p.second, 0 );
+}
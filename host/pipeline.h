@@ -0,0 +1,263 @@
+/*
+  Host side pipeline that splits the prime engine from whatever shows its
+  results.
+
+  On the device, MoulickApp tests a number and then draws it, so a slow
+  draw holds up the testing. Here the engine runs on a producer thread
+  and pushes one small NumberRecord per number into a bounded lock free
+  ring. A consumer thread drains the ring and hands the records to a Sink
+  (the display code against the emulated TFT, a logger, ...).
+
+  The engine never waits for the consumer. If the ring is full the oldest
+  record is dropped (and counted) to make room, so the display always
+  gets the latest numbers. If the consumer finds a long backlog it only
+  passes on the last `keep` records. The stats come across separately,
+  through a seqlock, once for every `batch` numbers. The records of a
+  batch only go in the ring after its stats are out, so the stats the
+  consumer reads are never older than the records it has.
+
+  Not for the Arduino: this needs threads and the STL.
+*/
+#ifndef _PIPELINE_H_
+#define _PIPELINE_H_
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "../moulick/primes.h"
+
+namespace pipeline {
+
+  using namespace primes;
+
+  // What the display needs to know about one number
+  struct NumberRecord
+  {
+    prime_t m;
+    uint32_t f16;   // fraction_tested_q16()
+    uint8_t flags;  // flag_prime | flag_twin_prime | flag_palindromic_prime
+  };
+
+  inline NumberRecord record_of( const PrimeClock& pc )
+  {
+    NumberRecord r;
+    r.m = pc.m;
+    r.f16 = pc.fraction_tested_q16();
+    r.flags = pc.is_prime ? flag_prime : 0;
+    if( pc.is_prime && pc.is_twin_prime ) r.flags |= flag_twin_prime;
+    if( pc.is_prime && pc.is_palindromic_prime ) r.flags |= flag_palindromic_prime;
+    return r;
+  }
+
+  // Sets a clock up so the display code, which reads a PrimeClock, draws
+  // r with stats s. The clock doesn't test anything, it is just a view
+  inline void show_on( PrimeClock& view, const NumberRecord& r, const ClockSnapshot& s )
+  {
+    view.m = r.m;
+    view.is_prime = r.flags & flag_prime;
+    view.is_twin_prime = r.flags & flag_twin_prime;
+    view.is_palindromic_prime = r.flags & flag_palindromic_prime;
+    if( view.is_prime ) view.set_string_representation();
+    // k / k_max chosen so fraction_tested_q16() gives back f16
+    view.pt.k_max = q16_one;
+    view.pt.k = r.f16 + 1;
+
+    view.last_prime = s.last_prime;
+    view.primes_found = s.primes_found;
+    view.twin_primes_found = s.twin_primes_found;
+    view.palindromic_primes_found = s.palindromic_primes_found;
+    for( int i = 0; i < 4; i++ )
+      for( int j = 0; j < 4; j++ )
+        view.rloks[ i ][ j ] = s.rloks[ i ][ j ];
+  }
+
+  /*
+    Bounded single producer, single consumer ring. N must be a power of
+    two. head and tail only ever go up (the slot is the index mod N). Only
+    the producer moves head. The consumer moves tail, and so does the
+    producer when push_overwrite() drops the oldest item, so the consumer
+    copies its items out first and then claims them with a CAS on tail. If
+    that fails the producer got there first and may have written over the
+    copies, so they are thrown away and the consumer tries again. The
+    copies are done a byte at a time with atomics, as in SeqLock, so the
+    losing copy isn't a data race. head and tail sit on their own cache
+    lines so the two threads don't fight over one.
+  */
+  template <typename T, size_t N>
+  class SpscRing
+  {
+    static_assert( N && ( N & ( N - 1 ) ) == 0, "N must be a power of two" );
+
+  public:
+    bool try_push( const T& x )
+    {
+      size_t h = head.load( std::memory_order_relaxed );
+      if( h - tail.load( std::memory_order_acquire ) == N ) return false;  // Full
+      put( items[ h & ( N - 1 ) ], x );
+      head.store( h + 1, std::memory_order_release );
+      return true;
+    }
+
+    // Always goes in. False if the oldest item had to go to make room
+    bool push_overwrite( const T& x )
+    {
+      size_t h = head.load( std::memory_order_relaxed ),
+             t = tail.load( std::memory_order_acquire );
+      // If the CAS fails the consumer just made room
+      bool dropped = h - t == N
+                     && tail.compare_exchange_strong( t, t + 1, std::memory_order_acq_rel );
+      put( items[ h & ( N - 1 ) ], x );
+      head.store( h + 1, std::memory_order_release );
+      return !dropped;
+    }
+
+    bool try_pop( T& x ) { return pop_all( &x, 1 ) == 1; }
+
+    // Everything there right now, up to max, in order. Returns the count
+    size_t pop_all( T* out, size_t max )
+    {
+      size_t t = tail.load( std::memory_order_acquire ), n;
+      do
+      {
+        n = head.load( std::memory_order_acquire ) - t;
+        if( n > max ) n = max;
+        for( size_t i = 0; i < n; i++ ) get( out[ i ], items[ ( t + i ) & ( N - 1 ) ] );
+      } while( n && !tail.compare_exchange_weak( t, t + n, std::memory_order_acq_rel,
+                                                 std::memory_order_acquire ) );
+      return n;
+    }
+
+    size_t size() const
+    {
+      return head.load( std::memory_order_acquire ) - tail.load( std::memory_order_acquire );
+    }
+
+    static constexpr size_t capacity() { return N; }
+
+  private:
+    alignas( 64 ) std::atomic<size_t> head{ 0 };  // Producer's
+    alignas( 64 ) std::atomic<size_t> tail{ 0 };  // Consumer's, and the producer's when it drops
+    T items[ N ];
+
+    static void put( T& slot, const T& x )
+    {
+      const uint8_t *src = (const uint8_t*) &x;
+      uint8_t *dst = (uint8_t*) &slot;
+      for( size_t i = 0; i < sizeof( T ); i++ ) __atomic_store_n( dst + i, src[ i ], __ATOMIC_RELAXED );
+    }
+
+    static void get( T& x, const T& slot )
+    {
+      const uint8_t *src = (const uint8_t*) &slot;
+      uint8_t *dst = (uint8_t*) &x;
+      for( size_t i = 0; i < sizeof( T ); i++ ) dst[ i ] = __atomic_load_n( src + i, __ATOMIC_RELAXED );
+    }
+  };
+
+  /*
+    Runs the engine from start and feeds sink until stop(). Sink needs
+
+      void show( const NumberRecord* r, size_t n, const ClockSnapshot& s );
+
+    called from the consumer thread with the records it has, oldest first,
+    and the latest stats. keep is how many of a backlog are worth showing:
+    a chart of 250 slots only needs the last 250 numbers. batch is how many
+    numbers the engine tests between publishing the stats.
+  */
+  template <typename Sink, size_t N = 4096>
+  class Pipeline
+  {
+  public:
+    std::atomic<uint64_t> produced{ 0 },  // numbers tested
+                          dropped{ 0 },   // old records pushed out of a full ring
+                          shown{ 0 },     // records passed to the sink
+                          coalesced{ 0 }, // records skipped from a backlog
+                          batches{ 0 };   // calls to the sink
+
+    static const size_t batch = 64;
+
+    Pipeline( Sink& _sink, size_t _keep = N ) : sink( _sink ), keep( _keep ? _keep : 1 ) {}
+
+    ~Pipeline() { stop(); }
+
+    Pipeline( const Pipeline& ) = delete;
+    Pipeline& operator=( const Pipeline& ) = delete;
+
+    void start( prime_t m )
+    {
+      running = true;
+      producer_done = false;
+      producer = std::thread( &Pipeline::produce, this, m );
+      consumer = std::thread( &Pipeline::consume, this );
+    }
+
+    // Anything still in the ring is shown before this returns
+    void stop()
+    {
+      if( !running ) return;
+      running = false;
+      producer.join();
+      consumer.join();
+    }
+
+  private:
+    Sink& sink;
+    size_t keep;
+    std::atomic<bool> running{ false },
+                      producer_done{ false };
+    SpscRing<NumberRecord, N> ring;
+    SeqLock<ClockSnapshot> stats;
+    std::thread producer, consumer;
+
+    void produce( prime_t m )
+    {
+      PrimeClock pc;
+      pc.restart_clock_from( m );
+      NumberRecord pending[ batch ];
+      ClockSnapshot s;
+      for( bool more = true; more; )
+      {
+        size_t n = 0;
+        while( n < batch && ( more = running ) )
+        {
+          pc.check_next();
+          pending[ n++ ] = record_of( pc );
+        }
+        if( !n ) break;
+        pc.snapshot( s );
+        stats.publish( s );
+        uint64_t lost = 0;
+        for( size_t i = 0; i < n; i++ ) lost += !ring.push_overwrite( pending[ i ] );
+        dropped.fetch_add( lost, std::memory_order_relaxed );
+        produced.fetch_add( n, std::memory_order_relaxed );
+      }
+      producer_done = true;
+    }
+
+    void consume()
+    {
+      std::vector<NumberRecord> batch( N );
+      ClockSnapshot s;
+      for( ;; )
+      {
+        bool last = producer_done;  // One more pass after the producer is done
+        size_t n = ring.pop_all( batch.data(), N );
+        if( n )
+        {
+          size_t skip = n > keep ? n - keep : 0;
+          while( !stats.try_read( s ) ) std::this_thread::yield();
+          sink.show( batch.data() + skip, n - skip, s );
+          coalesced += skip;
+          shown += n - skip;
+          batches++;
+        }
+        else if( last ) break;
+        else std::this_thread::yield();
+      }
+    }
+  };
+
+}
+
+#endif // _PIPELINE_H_
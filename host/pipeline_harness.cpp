@@ -0,0 +1,117 @@
+/*
+  How fast the engine runs with the display in the same loop (as on the
+  device) and with the display on the other end of a pipeline.h pipeline.
+
+  The emulated TFT is much faster than the real one, so each bus write
+  can be made to cost ns_per_write of busy waiting. ~500 ns is about
+  what the Uno's 8 bit bus manages.
+
+  Prints JSON lines, one per mode.
+
+  g++ -std=c++14 -O2 -pthread -Ihost host/pipeline_harness.cpp moulick/display.cpp -o ph
+  ./ph [seconds] [start m] [ns_per_write]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+
+#include <Elegoo_TFTLCD.h>
+
+#include "../moulick/display.h"
+#include "pipeline.h"
+
+using namespace display;
+using namespace pipeline;
+
+typedef std::chrono::steady_clock steady;
+
+// Burns the time the real bus would have taken for what was drawn since
+// the last call
+struct BusDelay
+{
+  Elegoo_TFTLCD *tft;
+  unsigned long ns_per_write;
+  uint64_t billed = 0;
+
+  void operator()()
+  {
+    uint64_t writes = tft->total().bus_writes;
+    auto until = steady::now() + std::chrono::nanoseconds( ( writes - billed ) * ns_per_write );
+    billed = writes;
+    while( steady::now() < until );
+  }
+};
+
+struct DisplaySink
+{
+  Elegoo_TFTLCD tft;
+  PrimeClock view;
+  Clock clock;
+  BusDelay delay;
+
+  DisplaySink( unsigned long ns_per_write ) : delay{ &tft, ns_per_write }
+  {
+    tft.setRotation( 1 );
+    clock.init( &tft, &view );
+  }
+
+  void show( const NumberRecord* r, size_t n, const ClockSnapshot& s )
+  {
+    for( size_t i = 0; i < n; i++ )
+    {
+      show_on( view, r[ i ], s );
+      clock.draw();
+      delay();
+    }
+  }
+};
+
+double seconds_since( steady::time_point t0 )
+{
+  return std::chrono::duration<double>( steady::now() - t0 ).count();
+}
+
+int main( int argc, char** argv )
+{
+  double seconds = argc > 1 ? atof( argv[ 1 ] ) : 2;
+  prime_t start = argc > 2 ? strtoul( argv[ 2 ], nullptr, 10 ) : 1000000;
+  unsigned long ns_per_write = argc > 3 ? strtoul( argv[ 3 ], nullptr, 10 ) : 500;
+
+  // Test, then draw, one after the other
+  {
+    Elegoo_TFTLCD tft;
+    tft.setRotation( 1 );
+    PrimeClock pc;
+    pc.restart_clock_from( start );
+    Clock clock;
+    clock.init( &tft, &pc );
+    BusDelay delay{ &tft, ns_per_write };
+    uint64_t n = 0;
+    auto t0 = steady::now();
+    while( seconds_since( t0 ) < seconds )
+    {
+      pc.check_next();
+      clock.draw();
+      delay();
+      n++;
+    }
+    printf( "{\"mode\": \"fused\", \"seconds\": %.2f, \"numbers_per_s\": %.0f, \"shown_per_s\": %.0f}\n",
+            seconds, n / seconds, n / seconds );
+  }
+
+  // Engine and display on their own threads
+  {
+    DisplaySink sink( ns_per_write );
+    Pipeline<DisplaySink> p( sink, CHART_N );
+    auto t0 = steady::now();
+    p.start( start );
+    while( seconds_since( t0 ) < seconds ) std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    p.stop();
+    double t = seconds_since( t0 );
+    printf( "{\"mode\": \"pipeline\", \"seconds\": %.2f, \"numbers_per_s\": %.0f, \"shown_per_s\": %.0f, "
+            "\"dropped\": %llu, \"coalesced\": %llu, \"batches\": %llu}\n",
+            t, p.produced / t, p.shown / t, (unsigned long long) p.dropped,
+            (unsigned long long) p.coalesced, (unsigned long long) p.batches );
+  }
+}
@@ -0,0 +1,292 @@
+/*
+  A permanent, compact record of the primes the clock finds.
+
+  File layout (host byte order):
+
+    ArchiveHeader
+    gap bytes       one byte per prime after the first
+    padding         zeros, up to a multiple of 8 bytes
+    Checkpoint[]    one for every `stride` primes
+
+  A gap g is stored as the byte g / 2. Gaps that don't fit (odd or >= 512,
+  i.e. only 2 -> 3 for anything we will ever scan) are a 0 byte followed
+  by the 8 byte gap. So it is ~1 byte per prime.
+
+  Every stride'th prime (64K by default) gets a checkpoint with its value,
+  its rank (n for the nth prime) and where its gaps start. The reader maps
+  the file and binary searches the checkpoints, then decodes at most one
+  stride of gaps, so queries don't touch the rest of the file.
+
+  Not for the Arduino: this needs files and mmap.
+*/
+#ifndef _PRIME_ARCHIVE_H_
+#define _PRIME_ARCHIVE_H_
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../moulick/primes.h"
+
+namespace archive {
+
+  using namespace primes;
+
+  const char archive_magic[ 8 ] = { 'M', 'O', 'U', 'L', 'P', 'R', 'M', '1' };
+
+  struct ArchiveHeader
+  {
+    char magic[ 8 ];
+    uint64_t n_primes,
+             first_rank,     // rank of the first prime in the file (1 if it is 2)
+             n_checkpoints,
+             index_offset;   // where the checkpoints start
+    uint32_t stride,         // primes per checkpoint
+             reserved;
+  };
+
+  struct Checkpoint
+  {
+    uint64_t value,
+             rank,
+             offset;  // of the gap to the next prime
+  };
+
+  /*
+    Appends primes, in increasing order, to a new archive. The index is
+    written out by close() (or the destructor), so an archive that was not
+    closed can't be read.
+  */
+  class ArchiveWriter
+  {
+  public:
+    explicit ArchiveWriter( const char* path, uint32_t stride = 65536 )
+    {
+      f = fopen( path, "wb" );
+      memset( &h, 0, sizeof( h ) );
+      memcpy( h.magic, archive_magic, sizeof( h.magic ) );
+      h.first_rank = 1;
+      h.stride = stride;
+      offset = 0;
+      if( f ) write( &h, sizeof( h ) );  // placeholder, filled in by close()
+    }
+
+    ~ArchiveWriter() { close(); }
+
+    ArchiveWriter( const ArchiveWriter& ) = delete;
+    ArchiveWriter& operator=( const ArchiveWriter& ) = delete;
+
+    bool good() const { return f != nullptr; }
+    uint64_t size() const { return h.n_primes; }
+
+    // p has to be bigger than the last prime added
+    void add( uint64_t p )
+    {
+      if( !f ) return;
+      if( h.n_primes )
+      {
+        uint64_t g = p - last;
+        if( ( g & 1 ) == 0 && g / 2 < 256 )
+          put_byte( g / 2 );
+        else
+        {
+          put_byte( 0 );
+          write( &g, sizeof( g ) );
+        }
+      }
+      if( h.n_primes % h.stride == 0 )
+        index.push_back( Checkpoint{ p, h.first_rank + h.n_primes, offset } );
+      last = p;
+      h.n_primes++;
+    }
+
+    // Call after check_next(). The clock knows how many primes came before,
+    // so an archive started after a jump still has true ranks
+    template <typename T, typename Tester>
+    void record( const BasicPrimeClock<T, Tester>& pc )
+    {
+      if( !pc.is_prime ) return;
+      if( h.n_primes == 0 ) h.first_rank = pc.primes_found;
+      add( pc.m );
+    }
+
+    // False if any of the archive failed to make it to disk (full disk ...)
+    bool close()
+    {
+      if( !f ) return false;
+      h.n_checkpoints = index.size();
+      // The reader uses the checkpoints in place, so they must be aligned
+      while( offset % alignof( Checkpoint ) ) put_byte( 0 );
+      h.index_offset = offset;
+      if( !index.empty() ) write( index.data(), index.size() * sizeof( Checkpoint ) );
+      if( fseek( f, 0, SEEK_SET ) ) ok = false;
+      write( &h, sizeof( h ) );
+      if( fclose( f ) ) ok = false;
+      f = nullptr;
+      return ok;
+    }
+
+  private:
+    FILE *f;
+    ArchiveHeader h;
+    std::vector<Checkpoint> index;
+    uint64_t last = 0,
+             offset;  // bytes written so far
+    bool ok = true;   // no write has failed
+
+    void put_byte( uint8_t b )
+    {
+      if( fputc( b, f ) == EOF ) ok = false;
+      offset++;
+    }
+
+    void write( const void* p, size_t n )
+    {
+      if( fwrite( p, 1, n, f ) != n ) ok = false;
+      offset += n;
+    }
+  };
+
+  /*
+    Read only view of an archive. Ranks are absolute: nth_prime( 1 ) is 2
+    and pi( x ) is the true count, as long as the writer was fed from the
+    start of the clock or from a restart_clock_from() that knew pi(m).
+
+    The archive only knows about x in [ first(), last() ] and n in
+    [ first_rank(), last_rank() ]. Outside that nth_prime() and pi() give 0
+    and is_prime() false, so check covers() if it matters.
+  */
+  class ArchiveReader
+  {
+  public:
+    ArchiveReader() {}
+    ~ArchiveReader() { close(); }
+
+    ArchiveReader( const ArchiveReader& ) = delete;
+    ArchiveReader& operator=( const ArchiveReader& ) = delete;
+
+    bool open( const char* path )
+    {
+      close();
+      int fd = ::open( path, O_RDONLY );
+      if( fd < 0 ) return false;
+      struct stat st;
+      if( fstat( fd, &st ) == 0 && (size_t) st.st_size >= sizeof( ArchiveHeader ) )
+      {
+        len = st.st_size;
+        void *p = mmap( nullptr, len, PROT_READ, MAP_SHARED, fd, 0 );
+        if( p != MAP_FAILED ) base = (const uint8_t*) p;
+      }
+      ::close( fd );
+      if( !base ) return false;
+
+      h = (const ArchiveHeader*) base;
+      if( memcmp( h->magic, archive_magic, sizeof( archive_magic ) ) != 0
+          || h->index_offset % alignof( Checkpoint )
+          || h->index_offset + h->n_checkpoints * sizeof( Checkpoint ) > len
+          || h->n_checkpoints == 0 )
+      {
+        close();
+        return false;
+      }
+      index = (const Checkpoint*) ( base + h->index_offset );
+      last_value = nth_prime( last_rank() );
+      return true;
+    }
+
+    void close()
+    {
+      if( base ) munmap( (void*) base, len );
+      base = nullptr;
+      h = nullptr;
+      index = nullptr;
+    }
+
+    uint64_t size() const { return h->n_primes; }
+    uint64_t first_rank() const { return h->first_rank; }
+    uint64_t last_rank() const { return h->first_rank + h->n_primes - 1; }
+    uint64_t first() const { return index[ 0 ].value; }
+    uint64_t last() const { return last_value; }
+
+    bool covers( uint64_t x ) const { return x >= first() && x <= last(); }
+
+    uint64_t nth_prime( uint64_t n ) const
+    {
+      if( n < first_rank() || n > last_rank() ) return 0;
+      uint64_t i = n - h->first_rank;
+      const Checkpoint& c = index[ i / h->stride ];
+      const uint8_t *q = base + c.offset;
+      uint64_t p = c.value;
+      for( uint64_t j = i % h->stride; j; j-- ) p += next_gap( q );
+      return p;
+    }
+
+    // Number of primes <= x
+    uint64_t pi( uint64_t x ) const
+    {
+      if( !covers( x ) ) return 0;
+      uint64_t p;
+      return rank_at_or_below( x, p );
+    }
+
+    bool is_prime( uint64_t x ) const
+    {
+      if( !covers( x ) ) return false;
+      uint64_t p;
+      rank_at_or_below( x, p );
+      return p == x;
+    }
+
+  private:
+    const uint8_t *base = nullptr;
+    size_t len = 0;
+    const ArchiveHeader *h = nullptr;
+    const Checkpoint *index = nullptr;
+    uint64_t last_value = 0;
+
+    static uint64_t next_gap( const uint8_t*& q )
+    {
+      uint8_t b = *q++;
+      if( b ) return 2 * (uint64_t) b;
+      uint64_t g;
+      memcpy( &g, q, sizeof( g ) );
+      q += sizeof( g );
+      return g;
+    }
+
+    // Rank of the largest archived prime <= x, which goes in p. x must be
+    // covered
+    uint64_t rank_at_or_below( uint64_t x, uint64_t& p ) const
+    {
+      // Last checkpoint <= x
+      uint64_t lo = 0, hi = h->n_checkpoints;
+      while( hi - lo > 1 )
+      {
+        uint64_t mid = ( lo + hi ) / 2;
+        if( index[ mid ].value <= x ) lo = mid; else hi = mid;
+      }
+
+      const Checkpoint& c = index[ lo ];
+      const uint8_t *q = base + c.offset;
+      uint64_t r = c.rank,
+               left = last_rank() - r;  // primes after this one in the file
+      p = c.value;
+      for( ; left; left-- )
+      {
+        uint64_t next = p + next_gap( q );
+        if( next > x ) break;
+        p = next;
+        r++;
+      }
+      return r;
+    }
+  };
+
+}
+
+#endif // _PRIME_ARCHIVE_H_
@@ -0,0 +1,199 @@
+/*
+  Timings for the hot paths in primes.h
+
+  Prints one JSON object per line, so runs can be saved and compared:
+
+    ./pb > before.jsonl
+    (change things)
+    ./pb --baseline before.jsonl
+
+  With a baseline each line also gets the old ns/op and the speedup.
+  --time s sets how long each benchmark runs for (default 0.25 s).
+
+  g++ -std=c++14 -O2 -pthread host/primes_bench.cpp -o pb
+*/
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+
+#include "../moulick/primes.h"
+
+using namespace primes;
+
+typedef std::chrono::steady_clock bench_clock;
+
+double time_budget = 0.25;  // seconds per benchmark
+std::map<std::string, double> baseline;  // "name@start" -> ns_per_op
+volatile uint64_t sink;  // keeps the optimizer from throwing the work away
+
+double seconds_since( bench_clock::time_point t0 )
+{
+  return std::chrono::duration<double>( bench_clock::now() - t0 ).count();
+}
+
+// divisions is < 0 when it doesn't apply
+void report( const char* name, uint64_t start, uint64_t ops, double secs, double divisions = -1 )
+{
+  double ns = 1e9 * secs / ops;
+  printf( "{\"name\": \"%s\", \"start\": %llu, \"ops\": %llu, \"seconds\": %.4f, "
+          "\"ns_per_op\": %.2f, \"ops_per_sec\": %.0f",
+          name, (unsigned long long) start, (unsigned long long) ops, secs, ns, ops / secs );
+  if( divisions >= 0 ) printf( ", \"divisions_per_number\": %.2f", divisions );
+
+  char key[ 128 ];
+  snprintf( key, sizeof( key ), "%s@%llu", name, (unsigned long long) start );
+  auto b = baseline.find( key );
+  if( b != baseline.end() )
+    printf( ", \"baseline_ns_per_op\": %.2f, \"speedup\": %.3f", b->second, b->second / ns );
+  printf( "}\n" );
+  fflush( stdout );
+}
+
+// Pulls "key": value out of one of our own output lines
+bool json_field( const std::string& line, const char* key, std::string& value )
+{
+  std::string k = std::string( "\"" ) + key + "\": ";
+  size_t i = line.find( k );
+  if( i == std::string::npos ) return false;
+  i += k.size();
+  if( line[ i ] == '"' )
+  {
+    size_t j = line.find( '"', i + 1 );
+    value = line.substr( i + 1, j - i - 1 );
+  }
+  else
+    value = line.substr( i, line.find_first_of( ",}", i ) - i );
+  return true;
+}
+
+bool load_baseline( const char* path )
+{
+  std::ifstream f( path );
+  if( !f ) return false;
+  std::string line, name, start, ns;
+  while( std::getline( f, line ) )
+    if( json_field( line, "name", name ) && json_field( line, "start", start )
+        && json_field( line, "ns_per_op", ns ) )
+      baseline[ name + "@" + start ] = atof( ns.c_str() );
+  return true;
+}
+
+// The trial division testers count the % they do in divisions. The rest
+// don't divide that way, and get -1 (not reported)
+template <typename Tester>
+auto divisions( const Tester& pt, int ) -> decltype( (double) pt.divisions ) { return pt.divisions; }
+
+template <typename Tester>
+double divisions( const Tester&, long ) { return -1; }
+
+// Numbers per second for is_prime over consecutive numbers from start
+template <typename Tester>
+void bench_is_prime( const char* name, uint64_t start )
+{
+  Tester pt;
+  uint64_t m = start, n = 0, found = 0;
+  double divs = 0, secs;
+  bench_clock::time_point t0 = bench_clock::now();
+  do
+  {
+    for( int i = 0; i < 256; i++, m++, n++ )
+    {
+      found += pt.is_prime( (prime_t) m );
+      divs += divisions( pt, 0 );
+    }
+  } while( ( secs = seconds_since( t0 ) ) < time_budget && m + 256 <= 4294967296ULL );
+  sink = found;
+  report( name, start, n, secs, divs < 0 ? -1 : divs / n );
+}
+
+void bench_check_next( uint64_t start )
+{
+  PrimeClock pc;
+  pc.restart_clock_from( (prime_t) start );  // not timed
+  uint64_t n = 0;
+  double divs = 0, secs;
+  bench_clock::time_point t0 = bench_clock::now();
+  do
+  {
+    for( int i = 0; i < 256; i++, n++ )
+    {
+      pc.check_next();
+      divs += divisions( pc.pt, 0 );
+    }
+  } while( ( secs = seconds_since( t0 ) ) < time_budget && pc.m <= 4294967295UL - 256 );
+  sink = pc.primes_found;
+  report( "check_next", start, n, secs, divs / n );
+}
+
+// Spread the inputs out so we don't just time one digit count
+template <typename F>
+void bench_op( const char* name, F op )
+{
+  uint64_t n = 0, acc = 0;
+  prime_t m = 1;
+  double secs;
+  bench_clock::time_point t0 = bench_clock::now();
+  do
+  {
+    for( int i = 0; i < 1024; i++, n++ )
+    {
+      m = m * 1664525UL + 1013904223UL;
+      acc += op( m );
+    }
+  } while( ( secs = seconds_since( t0 ) ) < time_budget );
+  sink = acc;
+  report( name, 0, n, secs );
+}
+
+int main( int argc, char** argv )
+{
+  for( int i = 1; i < argc; i++ )
+  {
+    if( !strcmp( argv[ i ], "--baseline" ) && i + 1 < argc )
+    {
+      if( !load_baseline( argv[ ++i ] ) )
+      {
+        fprintf( stderr, "Can't read baseline %s\n", argv[ i ] );
+        return 1;
+      }
+    }
+    else if( !strcmp( argv[ i ], "--time" ) && i + 1 < argc )
+      time_budget = atof( argv[ ++i ] );
+    else
+    {
+      fprintf( stderr, "Usage: %s [--baseline file.jsonl] [--time seconds]\n", argv[ 0 ] );
+      return 1;
+    }
+  }
+
+  const uint64_t starts[] = { 1000ULL, 1000000ULL, 1000000000ULL, 4294967296ULL - 100000 };
+  for( uint64_t start : starts )
+  {
+    bench_is_prime<PrimeTester>( "is_prime/PrimeTester", start );
+    bench_is_prime<WheelTester>( "is_prime/WheelTester", start );
+#if __cplusplus >= 201402L
+    bench_is_prime<SmallPrimeTester>( "is_prime/SmallPrimeTester", start );
+#endif
+    bench_is_prime<MillerRabinTester>( "is_prime/MillerRabinTester", start );
+    bench_check_next( start );
+  }
+
+  char buf[ p_max_d + 1 ];
+  bench_op( "prime_t_to_str", [ & ]( prime_t m ) { return (uint64_t) *prime_t_to_str( m, buf ); } );
+  // The clock calls this on a string it already has, so convert up front
+  static char strs[ 1024 ][ p_max_d + 1 ];
+  static const char *ptrs[ 1024 ];
+  prime_t m = 1;
+  for( int i = 0; i < 1024; i++ )
+  {
+    m = m * 1664525UL + 1013904223UL;
+    ptrs[ i ] = prime_t_to_str( m, strs[ i ] );
+  }
+  unsigned i = 0;
+  bench_op( "is_palindrome", [ & ]( prime_t ) { return (uint64_t) is_palindrome( ptrs[ i++ & 1023 ] ); } );
+  bench_op( "sqrt", []( prime_t m ) { return (uint64_t) primes::sqrt( m ); } );
+}
@@ -0,0 +1,198 @@
+/*
+  Host side parallel scanning of a range of numbers.
+
+  The clock on the device steps through the numbers one at a time. On the
+  host we can split a long range into chunks, scan the chunks on all the
+  cores and stitch the results back into the clock, so catching up over
+  billions of numbers does not take forever.
+
+  Not for the Arduino: this needs threads and the STL.
+*/
+#ifndef _SCANNER_H_
+#define _SCANNER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../moulick/primes.h"
+
+namespace scanner {
+
+  using namespace primes;
+
+  /*
+    A small work stealing thread pool for batches of independent tasks.
+
+    run( n, fn ) deals the task indices [0, n) out to the workers in
+    contiguous blocks (so neighbouring chunks tend to run on the same
+    thread). A worker takes tasks from the front of its own deque and, once
+    that runs dry, steals from the back of someone else's. run() returns
+    when every task has finished.
+  */
+  class WorkStealingPool
+  {
+  public:
+    explicit WorkStealingPool( unsigned n_threads = std::thread::hardware_concurrency() )
+      : queues( n_threads ? n_threads : 1 )
+    {
+      for( unsigned w = 0; w < queues.size(); w++ )
+        threads.emplace_back( &WorkStealingPool::work, this, w );
+    }
+
+    ~WorkStealingPool()
+    {
+      {
+        std::lock_guard<std::mutex> lock( mtx );
+        stop = true;
+      }
+      wake.notify_all();
+      for( auto& t : threads ) t.join();
+    }
+
+    WorkStealingPool( const WorkStealingPool& ) = delete;
+    WorkStealingPool& operator=( const WorkStealingPool& ) = delete;
+
+    unsigned size() const { return queues.size(); }
+
+    // fn( task, worker ) is called once for every task in [0, n_tasks)
+    void run( size_t n_tasks, std::function<void( size_t, unsigned )> fn )
+    {
+      if( n_tasks == 0 ) return;
+      std::unique_lock<std::mutex> lock( mtx );
+      job = std::move( fn );
+      pending = n_tasks;
+      size_t per_worker = ( n_tasks + queues.size() - 1 ) / queues.size();
+      for( size_t t = 0; t < n_tasks; t++ )
+      {
+        Queue& q = queues[ t / per_worker ];
+        std::lock_guard<std::mutex> qlock( q.mtx );
+        q.tasks.push_back( t );
+      }
+      generation++;
+      wake.notify_all();
+      done.wait( lock, [ this ] { return pending == 0; } );
+      job = nullptr;
+    }
+
+  private:
+    struct Queue
+    {
+      std::mutex mtx;
+      std::deque<size_t> tasks;
+    };
+
+    std::vector<Queue> queues;
+    std::vector<std::thread> threads;
+    std::function<void( size_t, unsigned )> job;
+
+    std::mutex mtx;  // guards job, pending, generation and stop
+    std::condition_variable wake, done;
+    size_t pending = 0;
+    uint64_t generation = 0;
+    bool stop = false;
+
+    bool next_task( unsigned w, size_t& task )
+    {
+      {
+        Queue& own = queues[ w ];
+        std::lock_guard<std::mutex> lock( own.mtx );
+        if( !own.tasks.empty() )
+        {
+          task = own.tasks.front();
+          own.tasks.pop_front();
+          return true;
+        }
+      }
+      for( unsigned i = 1; i < queues.size(); i++ )
+      {
+        Queue& victim = queues[ ( w + i ) % queues.size() ];
+        std::lock_guard<std::mutex> lock( victim.mtx );
+        if( !victim.tasks.empty() )
+        {
+          task = victim.tasks.back();
+          victim.tasks.pop_back();
+          return true;
+        }
+      }
+      return false;
+    }
+
+    void work( unsigned w )
+    {
+      uint64_t seen = 0;
+      for( ;; )
+      {
+        std::function<void( size_t, unsigned )> *fn;
+        {
+          std::unique_lock<std::mutex> lock( mtx );
+          wake.wait( lock, [ & ] { return stop || generation != seen; } );
+          if( stop ) return;
+          seen = generation;
+          fn = &job;  // stays put until pending drops to 0
+        }
+
+        size_t task;
+        while( next_task( w, task ) )
+        {
+          ( *fn )( task, w );
+          std::lock_guard<std::mutex> lock( mtx );
+          if( --pending == 0 ) done.notify_all();
+        }
+      }
+    }
+  };
+
+
+  // Scan [lo, hi] with the given tester
+  template <typename T, typename Tester>
+  BasicPrimeStats<T> scan_chunk( T lo, T hi, Tester& pt )
+  {
+    BasicPrimeStats<T> s( lo, hi );
+    for( T m = lo; ; m++ )
+    {
+      if( pt.is_prime( m ) ) s.add_prime( m );
+      if( m == hi ) break;
+    }
+    return s;
+  }
+
+  /*
+    Advance the clock to m_end (inclusive) using every worker in the pool.
+    Afterwards pc looks just like it would after ( m_end - pc.m ) calls to
+    check_next(), apart from the tester's k/k_max.
+  */
+  template <typename T, typename Tester>
+  void scan_to( BasicPrimeClock<T, Tester>& pc, T m_end, WorkStealingPool& pool,
+                T chunk = 16 * (T) sieve_window_bytes )
+  {
+    if( m_end <= pc.m ) return;
+
+    T lo = pc.m + 1;
+    size_t n_chunks = ( m_end - lo ) / chunk + 1;
+    std::vector<BasicPrimeStats<T>> results( n_chunks );
+
+    std::vector<std::unique_ptr<BasicSieveTester<T>>> testers;
+    for( unsigned w = 0; w < pool.size(); w++ )
+      testers.emplace_back( new BasicSieveTester<T>() );
+
+    pool.run( n_chunks, [ & ]( size_t c, unsigned w ) {
+      T c_lo = lo + c * chunk,
+        c_hi = ( c + 1 == n_chunks ) ? m_end : c_lo + ( chunk - 1 );
+      results[ c ] = scan_chunk( c_lo, c_hi, *testers[ w ] );
+    } );
+
+    // Chunks are merged in order, so seams are counted exactly as
+    // check_next() would count them
+    BasicPrimeStats<T> total;
+    for( const auto& s : results ) total.merge( s );
+    pc.absorb( total );
+  }
+
+}
+
+#endif // _SCANNER_H_
@@ -0,0 +1,67 @@
+/*
+  Generates moulick/clock_snapshots.h: the full clock state at each of the
+  start points the touch screen can jump to (2^1 and 2^8 .. 2^31), so the
+  device can restore them instead of starting the stats from zero.
+
+  g++ -std=c++11 -O2 -pthread host/snapshot_gen.cpp -o sg && ./sg > moulick/clock_snapshots.h
+*/
+#include <cstdio>
+#include <vector>
+
+#include "scanner.h"
+
+using namespace primes;
+
+int main()
+{
+  std::vector<uint8_t> pows;
+  pows.push_back( 1 );
+  for( uint8_t pow = 8; pow <= 31; pow++ ) pows.push_back( pow );
+
+  scanner::WorkStealingPool pool;
+  PrimeClock pc;
+
+  printf( "/*\n"
+          "  Clock state at each touch screen start point.\n"
+          "  Generated by host/snapshot_gen.cpp, don't edit by hand.\n"
+          "*/\n"
+          "#ifndef _CLOCK_SNAPSHOTS_H_\n"
+          "#define _CLOCK_SNAPSHOTS_H_\n\n"
+          "#include \"primes.h\"\n\n"
+          "namespace primes {\n\n"
+          "  const uint8_t n_clock_snapshots = %u;\n\n"
+          "  const ClockSnapshot clock_snapshots[ n_clock_snapshots ] PRIMES_PROGMEM = {\n",
+          (unsigned) pows.size() );
+
+  for( size_t i = 0; i < pows.size(); i++ )
+  {
+    const prime_t m = (prime_t) 1 << pows[ i ];
+    scanner::scan_to( pc, m, pool );
+
+    printf( "    { %luUL, %luUL, %luUL, %luUL, %luUL,\n      {",
+            (unsigned long) pc.m, (unsigned long) pc.last_prime,
+            (unsigned long) pc.primes_found, (unsigned long) pc.twin_primes_found,
+            (unsigned long) pc.palindromic_primes_found );
+    for( int r = 0; r < 4; r++ )
+      printf( " { %luUL, %luUL, %luUL, %luUL }%s",
+              (unsigned long) pc.rloks[ r ][ 0 ], (unsigned long) pc.rloks[ r ][ 1 ],
+              (unsigned long) pc.rloks[ r ][ 2 ], (unsigned long) pc.rloks[ r ][ 3 ],
+              r < 3 ? "," : "" );
+    printf( " } }%s  // 2^%u\n", i + 1 < pows.size() ? "," : "", pows[ i ] );
+    fprintf( stderr, "2^%u done\n", pows[ i ] );
+  }
+
+  printf( "  };\n\n"
+          "  // Copy the snapshot for m into s. False if m isn't a start point\n"
+          "  inline bool find_clock_snapshot( prime_t m, ClockSnapshot& s )\n"
+          "  {\n"
+          "    for( uint8_t i = 0; i < n_clock_snapshots; i++ )\n"
+          "    {\n"
+          "      primes_read_block( &s, &clock_snapshots[ i ], sizeof( ClockSnapshot ) );\n"
+          "      if( s.m == m ) return true;\n"
+          "    }\n"
+          "    return false;\n"
+          "  }\n\n"
+          "}\n\n"
+          "#endif // _CLOCK_SNAPSHOTS_H_\n" );
+}
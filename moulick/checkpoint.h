@@ -0,0 +1,157 @@
+/*
+  Saves the clock state so a power cycle doesn't send us back to m = 1.
+
+  The state goes into one of two fixed slots (A/B), alternating, each with
+  a sequence number and a CRC. If the power goes in the middle of a write
+  only that slot is torn: its CRC won't match and we resume from the other
+  one, which still holds the previous good state.
+
+  On the Uno the slots live in EEPROM (2 x 90 bytes of the 1 kB, a slot
+  being seq, snapshot and CRC). On the host they live in a file.
+*/
+#ifndef _CHECKPOINT_H_
+#define _CHECKPOINT_H_
+
+#ifdef __AVR__
+#include <avr/eeprom.h>
+#else
+#include <stdio.h>
+#endif
+
+#include "primes.h"
+
+namespace checkpoint {
+
+  using namespace primes;
+
+  struct CheckpointRecord
+  {
+    uint32_t seq;        // higher is newer
+    ClockSnapshot state;
+    uint16_t crc;        // over seq and state
+  };
+
+  // CRC-16/CCITT, bit by bit so we don't spend flash on a table
+  inline uint16_t crc16( const uint8_t* p, uint16_t n, uint16_t crc = 0xffff )
+  {
+    while( n-- )
+    {
+      crc ^= (uint16_t) *p++ << 8;
+      for( uint8_t b = 0; b < 8; b++ )
+        crc = ( crc & 0x8000 ) ? ( crc << 1 ) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+  }
+
+  inline uint16_t record_crc( const CheckpointRecord& r )
+  {
+    return crc16( (const uint8_t*) &r, (uint16_t) ( (const uint8_t*) &r.crc - (const uint8_t*) &r ) );
+  }
+
+#ifdef __AVR__
+  struct EepromStorage
+  {
+    uint16_t base;  // EEPROM address of slot A
+
+    explicit EepromStorage( uint16_t _base = 0 ) : base( _base ) {}
+
+    bool read( uint16_t offset, void* buf, uint16_t n )
+    {
+      eeprom_read_block( buf, (const void*) ( base + offset ), n );
+      return true;
+    }
+
+    // update only writes the bytes that changed, which saves EEPROM wear
+    bool write( uint16_t offset, const void* buf, uint16_t n )
+    {
+      eeprom_update_block( buf, (void*) ( base + offset ), n );
+      return true;
+    }
+  };
+#else
+  struct FileStorage
+  {
+    const char *path;
+
+    explicit FileStorage( const char* _path ) : path( _path ) {}
+
+    bool read( uint16_t offset, void* buf, uint16_t n )
+    {
+      FILE *f = fopen( path, "rb" );
+      if( !f ) return false;
+      bool ok = fseek( f, offset, SEEK_SET ) == 0 && fread( buf, 1, n, f ) == n;
+      fclose( f );
+      return ok;
+    }
+
+    bool write( uint16_t offset, const void* buf, uint16_t n )
+    {
+      FILE *f = fopen( path, "r+b" );
+      if( !f ) f = fopen( path, "w+b" );
+      if( !f ) return false;
+      bool ok = fseek( f, offset, SEEK_SET ) == 0 && fwrite( buf, 1, n, f ) == n;
+      ok = fflush( f ) == 0 && ok;
+      fclose( f );
+      return ok;
+    }
+  };
+#endif
+
+  /*
+    load() picks the newest slot with a good CRC. save() always writes the
+    slot load() did not pick, so the newest good record is never the one
+    being overwritten.
+  */
+  template <typename Storage>
+  struct BasicCheckpointer
+  {
+    Storage store;
+    uint32_t seq;   // of the newest good record
+    uint8_t next_slot;
+
+    explicit BasicCheckpointer( const Storage& _store ) : store( _store ), seq( 0 ), next_slot( 0 ) {}
+
+    bool read_slot( uint8_t slot, CheckpointRecord& r )
+    {
+      return store.read( slot * sizeof( CheckpointRecord ), &r, sizeof( r ) )
+             && r.crc == record_crc( r );
+    }
+
+    bool load( ClockSnapshot& s )
+    {
+      CheckpointRecord a, b;
+      bool a_ok = read_slot( 0, a ),
+           b_ok = read_slot( 1, b );
+      if( !a_ok && !b_ok ) return false;
+
+      // Serial number arithmetic, in case seq ever wraps
+      bool b_newer = b_ok && ( !a_ok || (int32_t) ( b.seq - a.seq ) > 0 );
+      const CheckpointRecord& r = b_newer ? b : a;
+      s = r.state;
+      seq = r.seq;
+      next_slot = b_newer ? 0 : 1;
+      return true;
+    }
+
+    bool save( const ClockSnapshot& s )
+    {
+      CheckpointRecord r;
+      r.seq = seq + 1;
+      r.state = s;
+      r.crc = record_crc( r );
+      if( !store.write( next_slot * sizeof( CheckpointRecord ), &r, sizeof( r ) ) ) return false;
+      seq = r.seq;
+      next_slot ^= 1;
+      return true;
+    }
+  };
+
+#ifdef __AVR__
+  typedef BasicCheckpointer<EepromStorage> Checkpointer;
+#else
+  typedef BasicCheckpointer<FileStorage> Checkpointer;
+#endif
+
+}
+
+#endif // _CHECKPOINT_H_
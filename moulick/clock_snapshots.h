@@ -0,0 +1,80 @@
+/*
+  Clock state at each touch screen start point.
+  Generated by host/snapshot_gen.cpp, don't edit by hand.
+*/
+#ifndef _CLOCK_SNAPSHOTS_H_
+#define _CLOCK_SNAPSHOTS_H_
+
+#include "primes.h"
+
+namespace primes {
+
+  const uint8_t n_clock_snapshots = 25;
+
+  const ClockSnapshot clock_snapshots[ n_clock_snapshots ] PRIMES_PROGMEM = {
+    { 2UL, 2UL, 1UL, 0UL, 1UL,
+      { { 0UL, 0UL, 0UL, 0UL }, { 0UL, 0UL, 0UL, 0UL }, { 0UL, 0UL, 0UL, 0UL }, { 0UL, 0UL, 0UL, 0UL } } },  // 2^1
+    { 256UL, 251UL, 54UL, 17UL, 10UL,
+      { { 2UL, 6UL, 4UL, 0UL }, { 0UL, 0UL, 7UL, 6UL }, { 5UL, 3UL, 0UL, 5UL }, { 6UL, 4UL, 1UL, 1UL } } },  // 2^8
+    { 512UL, 509UL, 97UL, 24UL, 14UL,
+      { { 3UL, 10UL, 7UL, 2UL }, { 0UL, 1UL, 10UL, 13UL }, { 11UL, 5UL, 1UL, 7UL }, { 8UL, 8UL, 5UL, 2UL } } },  // 2^9
+    { 1024UL, 1021UL, 172UL, 36UL, 20UL,
+      { { 6UL, 15UL, 14UL, 5UL }, { 4UL, 1UL, 19UL, 18UL }, { 16UL, 13UL, 5UL, 12UL }, { 15UL, 13UL, 7UL, 5UL } } },  // 2^10
+    { 2048UL, 2039UL, 309UL, 62UL, 20UL,
+      { { 11UL, 30UL, 26UL, 7UL }, { 12UL, 3UL, 30UL, 33UL }, { 24UL, 23UL, 8UL, 24UL }, { 27UL, 22UL, 14UL, 11UL } } },  // 2^11
+    { 4096UL, 4093UL, 564UL, 107UL, 20UL,
+      { { 16UL, 51UL, 52UL, 19UL }, { 21UL, 9UL, 53UL, 57UL }, { 42UL, 42UL, 15UL, 45UL }, { 59UL, 39UL, 23UL, 17UL } } },  // 2^12
+    { 8192UL, 8191UL, 1028UL, 177UL, 20UL,
+      { { 35UL, 84UL, 101UL, 32UL }, { 46UL, 24UL, 87UL, 101UL }, { 72UL, 79UL, 26UL, 84UL }, { 100UL, 71UL, 46UL, 36UL } } },  // 2^13
+    { 16384UL, 16381UL, 1900UL, 290UL, 37UL,
+      { { 63UL, 158UL, 180UL, 67UL }, { 87UL, 46UL, 158UL, 187UL }, { 137UL, 142UL, 54UL, 148UL }, { 182UL, 132UL, 88UL, 67UL } } },  // 2^14
+    { 32768UL, 32749UL, 3512UL, 505UL, 55UL,
+      { { 119UL, 316UL, 316UL, 120UL }, { 171UL, 89UL, 274UL, 351UL }, { 238UL, 262UL, 110UL, 275UL }, { 343UL, 218UL, 184UL, 122UL } } },  // 2^15
+    { 65536UL, 65521UL, 6542UL, 860UL, 70UL,
+      { { 225UL, 557UL, 582UL, 260UL }, { 350UL, 197UL, 489UL, 609UL }, { 434UL, 487UL, 214UL, 512UL }, { 616UL, 404UL, 361UL, 241UL } } },  // 2^16
+    { 131072UL, 131071UL, 12251UL, 1526UL, 113UL,
+      { { 464UL, 1020UL, 1086UL, 488UL }, { 668UL, 399UL, 924UL, 1089UL }, { 803UL, 878UL, 401UL, 987UL }, { 1124UL, 783UL, 657UL, 476UL } } },  // 2^17
+    { 262144UL, 262139UL, 23000UL, 2679UL, 113UL,
+      { { 903UL, 1868UL, 1994UL, 963UL }, { 1255UL, 783UL, 1733UL, 1991UL }, { 1505UL, 1625UL, 773UL, 1859UL }, { 2065UL, 1486UL, 1261UL, 932UL } } },  // 2^18
+    { 524288UL, 524287UL, 43390UL, 4750UL, 113UL,
+      { { 1719UL, 3501UL, 3692UL, 1932UL }, { 2401UL, 1516UL, 3257UL, 3662UL }, { 2856UL, 3026UL, 1527UL, 3475UL }, { 3868UL, 2793UL, 2408UL, 1753UL } } },  // 2^19
+    { 1048576UL, 1048573UL, 82025UL, 8535UL, 119UL,
+      { { 3357UL, 6567UL, 6833UL, 3738UL }, { 4574UL, 2941UL, 6091UL, 6912UL }, { 5301UL, 5682UL, 2997UL, 6539UL }, { 7263UL, 5329UL, 4597UL, 3300UL } } },  // 2^20
+    { 2097152UL, 2097143UL, 155611UL, 15500UL, 303UL,
+      { { 6405UL, 12363UL, 12781UL, 7328UL }, { 8793UL, 5709UL, 11505UL, 12903UL }, { 10019UL, 10750UL, 5774UL, 12385UL }, { 13660UL, 10089UL, 8867UL, 6276UL } } },  // 2^21
+    { 4194304UL, 4194301UL, 295947UL, 27995UL, 475UL,
+      { { 12371UL, 23272UL, 24034UL, 14263UL }, { 16893UL, 11174UL, 21871UL, 24086UL }, { 19043UL, 20443UL, 11207UL, 23347UL }, { 25634UL, 19135UL, 16927UL, 12243UL } } },  // 2^22
+    { 8388608UL, 8388593UL, 564163UL, 50638UL, 630UL,
+      { { 23896UL, 43901UL, 45470UL, 27730UL }, { 32605UL, 21847UL, 41311UL, 45314UL }, { 36190UL, 38938UL, 21819UL, 44154UL }, { 48306UL, 36392UL, 32500UL, 23786UL } } },  // 2^23
+    { 16777216UL, 16777213UL, 1077871UL, 92246UL, 781UL,
+      { { 46322UL, 83366UL, 85542UL, 54161UL }, { 62848UL, 42880UL, 78436UL, 85416UL }, { 69128UL, 73867UL, 42820UL, 83588UL }, { 91093UL, 69468UL, 62604UL, 46328UL } } },  // 2^24
+    { 33554432UL, 33554393UL, 2063689UL, 168617UL, 781UL,
+      { { 89781UL, 158315UL, 162383UL, 105261UL }, { 120933UL, 83837UL, 149047UL, 162196UL }, { 132265UL, 141567UL, 83603UL, 158674UL }, { 172761UL, 132295UL, 121075UL, 89692UL } } },  // 2^25
+    { 67108864UL, 67108859UL, 3957809UL, 309561UL, 781UL,
+      { { 173953UL, 301725UL, 308332UL, 205199UL }, { 233379UL, 163398UL, 284677UL, 308277UL }, { 253196UL, 271088UL, 163277UL, 302025UL }, { 328681UL, 253520UL, 233299UL, 173779UL } } },  // 2^26
+    { 134217728UL, 134217689UL, 7603553UL, 571313UL, 1281UL,
+      { { 338245UL, 576364UL, 587521UL, 398547UL }, { 450061UL, 319023UL, 544513UL, 587444UL }, { 486380UL, 518905UL, 319118UL, 576740UL }, { 625991UL, 486749UL, 449990UL, 337958UL } } },  // 2^27
+    { 268435456UL, 268435399UL, 14630843UL, 1056281UL, 2205UL,
+      { { 657582UL, 1102864UL, 1121072UL, 776228UL }, { 870724UL, 623706UL, 1043183UL, 1120361UL }, { 935243UL, 995686UL, 623506UL, 1103377UL }, { 1194197UL, 935718UL, 870050UL, 657342UL } } },  // 2^28
+    { 536870912UL, 536870909UL, 28192750UL, 1961080UL, 3485UL,
+      { { 1279828UL, 2113304UL, 2144187UL, 1510145UL }, { 1683281UL, 1221591UL, 2000639UL, 2143174UL }, { 1799689UL, 1913896UL, 1220068UL, 2114668UL }, { 2284666UL, 1799894UL, 1683426UL, 1280290UL } } },  // 2^29
+    { 1073741824UL, 1073741789UL, 54400028UL, 3650557UL, 5953UL,
+      { { 2493459UL, 4058980UL, 4107300UL, 2939602UL }, { 3261053UL, 2388517UL, 3845129UL, 4105819UL }, { 3470227UL, 3683348UL, 2386996UL, 4059936UL }, { 4374602UL, 3469673UL, 3261081UL, 2494302UL } } },  // 2^30
+    { 2147483648UL, 2147483647UL, 105097565UL, 6810670UL, 5953UL,
+      { { 4861281UL, 7804905UL, 7883152UL, 5724068UL }, { 6318673UL, 4673538UL, 7400783UL, 7881021UL }, { 6698745UL, 7098204UL, 4670607UL, 7807807UL }, { 8394707UL, 6697368UL, 6320821UL, 4861881UL } } }  // 2^31
+  };
+
+  // Copy the snapshot for m into s. False if m isn't a start point
+  inline bool find_clock_snapshot( prime_t m, ClockSnapshot& s )
+  {
+    for( uint8_t i = 0; i < n_clock_snapshots; i++ )
+    {
+      primes_read_block( &s, &clock_snapshots[ i ], sizeof( ClockSnapshot ) );
+      if( s.m == m ) return true;
+    }
+    return false;
+  }
+
+}
+
+#endif // _CLOCK_SNAPSHOTS_H_
@@ -0,0 +1,135 @@
+/*
+  Debouncing for the touch screen, with no pin twiddling, so it can be
+  tested on the host with a scripted feed of points (see touch_test.cpp).
+
+  The resistive panel is noisy as the stylus goes down and comes up, and
+  the pressure drops out now and then even when it is held. So a touch
+  goes through
+
+    Idle     -- pressed -->                          Pressed
+    Pressed  -- lifted (a bounce) -->                Idle
+    Pressed  -- still pressed after DEBOUNCE_MS -->  Held      (a Tap event)
+    Held     -- lifted -->                           Released
+    Released -- pressed again (a drop out) -->       Held
+    Released -- nothing for RELEASE_MS -->           Idle
+
+  update() takes one sample and the time and returns straight away, no
+  delay(). Taps go into an EventQueue for the app to pick up when it has
+  time.
+*/
+#ifndef _DEBOUNCE_H_
+#define _DEBOUNCE_H_
+
+#include <stdint.h>
+#include <TouchScreen.h>
+
+#include "tftconstants.h"
+
+#define DEBOUNCE_MS 40    // Pressed this long before it counts
+#define RELEASE_MS  150   // Lifted this long before the touch is over
+
+namespace debounce
+{
+  struct TouchEvent
+  {
+    TSPoint p;        // Where the touch settled, screen co-ordinates
+    unsigned long t;  // millis() when it did
+  };
+
+  /*
+    A lock free ring buffer for one producer and one consumer, e.g. an ISR
+    and the main loop. Each index is written by one side only and is a
+    byte, so loads and stores of it are atomic even on the AVR. The
+    acquire/release pairs make sure the item is in place before the other
+    side sees the index move. Holds N - 1 items, and push() drops the event
+    when full.
+  */
+  template <typename T, uint8_t N>
+  struct EventQueue
+  {
+    T items[ N ];
+    uint8_t head,  // next slot to write, producer's
+            tail;  // next slot to read, consumer's
+
+    EventQueue() : head( 0 ), tail( 0 ) {}
+
+    bool push( const T& e )
+    {
+      uint8_t h = __atomic_load_n( &head, __ATOMIC_RELAXED ),
+              next = ( h + 1 ) % N;
+      if( next == __atomic_load_n( &tail, __ATOMIC_ACQUIRE ) ) return false;  // Full
+      items[ h ] = e;
+      __atomic_store_n( &head, next, __ATOMIC_RELEASE );
+      return true;
+    }
+
+    bool pop( T& e )
+    {
+      uint8_t t = __atomic_load_n( &tail, __ATOMIC_RELAXED );
+      if( t == __atomic_load_n( &head, __ATOMIC_ACQUIRE ) ) return false;  // Empty
+      e = items[ t ];
+      __atomic_store_n( &tail, ( t + 1 ) % N, __ATOMIC_RELEASE );
+      return true;
+    }
+
+    bool empty() const
+    {
+      return __atomic_load_n( &tail, __ATOMIC_ACQUIRE ) == __atomic_load_n( &head, __ATOMIC_ACQUIRE );
+    }
+  };
+
+  enum class TouchState : uint8_t { Idle = 0, Pressed, Held, Released };
+
+  inline bool is_pressed( const TSPoint& p ) { return p.z > MINPRESSURE && p.z < MAXPRESSURE; }
+
+  struct TouchDebouncer
+  {
+    TouchState state;
+    unsigned long since;  // millis() of the last change of state
+    TouchEvent event;     // The last tap
+
+    TouchDebouncer() : state( TouchState::Idle ), since( 0 ) {}
+
+    // Returns true when a tap has just happened, and it is in event
+    bool update( const TSPoint& p, unsigned long now )
+    {
+      bool down = is_pressed( p );
+      switch( state )
+      {
+        case TouchState::Idle:
+          if( down ) go( TouchState::Pressed, now );
+          break;
+
+        case TouchState::Pressed:
+          if( !down ) go( TouchState::Idle, now );
+          else if( now - since >= DEBOUNCE_MS )
+          {
+            go( TouchState::Held, now );
+            event.p = p;
+            event.t = now;
+            return true;
+          }
+          break;
+
+        case TouchState::Held:
+          if( !down ) go( TouchState::Released, now );
+          break;
+
+        case TouchState::Released:
+          if( down ) go( TouchState::Held, now );
+          else if( now - since >= RELEASE_MS ) go( TouchState::Idle, now );
+          break;
+      }
+      return false;
+    }
+
+    void go( TouchState s, unsigned long now )
+    {
+      state = s;
+      since = now;
+    }
+  };
+
+}
+
+#endif // _DEBOUNCE_H_
@@ -7,62 +7,77 @@ namespace display {
 
   using namespace primes;
 
+  // Indexed by the color index kept in RadialChart::bars
+  const uint16_t bar_colors[] = {
+    CHART_LINE_COL,
+    CHART_PRIME_COL,
+    CHART_TWIN_PRIME_COL,
+    CHART_PALINDROMIC_PRIME_COL,
+    CHART_TWIN_AND_PALINDROMIC_PRIME_COL
+  };
+
   void RadialChart::init( Elegoo_TFTLCD *_tft )
   {
     tft = _tft;
     tft->fillCircle( CHART_X, CHART_Y, CHART_BASE_R1, CHART_BASE_COL );
     tft->fillCircle( CHART_X, CHART_Y, CHART_BASE_R0 - 1, BACKGROUND );  
+    for( int i = 0; i < CHART_N; i++ ) bars[ i ] = 0;  // The screen has just been cleared
   }
 
-  void RadialChart::draw(prime_t m, float f, byte m_type)
+  void RadialChart::draw(prime_t m, uint32_t f16, byte m_type)
   {
-    float theta = D_THETA * (float)(m % CHART_N);
-    uint16_t color = CHART_LINE_COL;
+    uint16_t slot = m % CHART_N;
+    uint8_t color_index = 0;
     switch( m_type )
     {
       case PRIME: 
-        color = CHART_PRIME_COL;
+        color_index = 1;
         break;
       case TWIN: 
-        color = CHART_TWIN_PRIME_COL;
+        color_index = 2;
         break;
       case PALINDROME: 
-        color = CHART_PALINDROMIC_PRIME_COL;
+        color_index = 3;
         break;        
       case TWIN & PALINDROME: 
-        color = CHART_TWIN_AND_PALINDROMIC_PRIME_COL;
+        color_index = 4;
         break;
     }
 
-    cursor( theta + D_THETA, BACKGROUND );
-    cursor( theta, CHART_BASE_COL );
+    cursor( slot + 1 < CHART_N ? slot + 1 : 0, BACKGROUND );
+    cursor( slot, CHART_BASE_COL );
     
-    radial_line( theta, 1.0, BACKGROUND );
-    radial_line( theta, f, color );
+    radial_line( slot, f16, color_index );
   }
 
-  void RadialChart::cursor( float theta, uint16_t color )
+  void RadialChart::cursor( uint16_t slot, uint16_t color )
   {
-    float st = sin( theta ), 
-          ct = cos( theta );
-    int x0 = CHART_X + CHART_BASE_R0 * st,
-        y0 = CHART_Y - CHART_BASE_R0 * ct,
-        x1 = CHART_X + CHART_BASE_R1 * st,
-        y1 = CHART_Y - CHART_BASE_R1 * ct;
-    tft->drawLine( x0, y0, x1, y1, color );
+    SpokeEnds e = read_spoke( ChartGeometry<>::cursor, slot );
+    tft->drawLine( CHART_X + e.x0, CHART_Y + e.y0, CHART_X + e.x1, CHART_Y + e.y1, color );
   }
 
-  void RadialChart::radial_line( float theta, float f, uint16_t color )
+  // Bring the bar in this slot to fraction f16 in the given color, touching
+  // only the pixels that change
+  void RadialChart::radial_line( uint16_t slot, uint32_t f16, uint8_t color_index )
   {
-    float st = sin( theta ), 
-          ct = cos( theta );
-    int x0 = CHART_X + CHART_R0 * st,
-        y0 = CHART_Y - CHART_R0 * ct,
-        x1 = CHART_X + ( CHART_R0 + CHART_DR ) * st,
-        y1 = CHART_Y - ( CHART_R0 + CHART_DR ) * ct;
-
-    //tft->drawLine( x0, y0, x1, y1, color );
-    fractional_bresenham( x0, y0, x1, y1, f, color, tft );
+    SpokeEnds e = read_spoke( ChartGeometry<>::bar, slot );
+    int16_t x0 = CHART_X + e.x0,
+            y0 = CHART_Y + e.y0,
+            x1 = CHART_X + e.x1,
+            y1 = CHART_Y + e.y1;
+
+    uint8_t old_color = bars[ slot ] / BAR_LENGTHS,
+            old_len = bars[ slot ] % BAR_LENGTHS,
+            len = bresenham_length( x0, y0, x1, y1, f16 );
+
+    if( color_index != old_color )
+      bresenham_range( x0, y0, x1, y1, 0, len, bar_colors[ color_index ], tft );
+    else if( len > old_len )  // grown
+      bresenham_range( x0, y0, x1, y1, old_len, len, bar_colors[ color_index ], tft );
+    if( old_len > len )  // shrunk
+      bresenham_range( x0, y0, x1, y1, len, old_len, BACKGROUND, tft );
+
+    bars[ slot ] = color_index * BAR_LENGTHS + len;
   }
 
   
@@ -136,7 +151,7 @@ namespace display {
     if( pc->is_prime ) m_type = PRIME;
     if( pc->is_twin_prime ) m_type &= TWIN;
     if( pc->is_palindromic_prime ) m_type &= PALINDROME; 
-    radial_chart.draw( pc->m, min( pc->fraction_tested(), 1.0 ), m_type );
+    radial_chart.draw( pc->m, pc->fraction_tested_q16(), m_type );
 
     if( pc->is_prime ) digit_display.draw( pc->m_as_string() );  
   }
@@ -144,7 +159,7 @@ namespace display {
   void Clock::partial_draw()
   {
     byte m_type = COMPOSITE;  // We only refresh when we are in the middle of testing
-    radial_chart.draw( pc->m, min( pc->fraction_tested(), 1.0 ), m_type );
+    radial_chart.draw( pc->m, pc->fraction_tested_q16(), m_type );
   }
 
 
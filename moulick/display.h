@@ -62,30 +62,86 @@ namespace display {
   using namespace primes;
 
 
-  // KG's modification for Bresenham's algorithm for the radial plot
-  // modified from https://gist.github.com/bert/1085538#file-plot_line-c
-  inline void fractional_bresenham(
+  // A run of n pixels from (x, y) in a row (horizontal) or column, drawn
+  // with one address window instead of one per pixel
+  inline void draw_run(
+    int16_t x, int16_t y, int16_t n, bool horizontal,
+    int8_t sx, int8_t sy,
+    uint16_t color,
+    Elegoo_TFTLCD *tft)
+  {
+    if( n == 1 ) tft->drawPixel( x, y, color );
+    else if( horizontal ) tft->drawFastHLine( sx > 0 ? x : x - n + 1, y, n, color );
+    else tft->drawFastVLine( x, sy > 0 ? y : y - n + 1, n, color );
+  }
+
+  // How many pixels fractional_bresenham draws for fraction f16 (Q16). The
+  // major axis moves one pixel every step, so this is the distance along
+  // it to floor( x0 + ( x1 - x0 ) * f ) (the end point the float version
+  // used), plus one. Integer only: |d| <= 2^9, so |d| * f16 fits in 32 bits
+  inline int16_t bresenham_length(
+    int16_t x0, int16_t y0,
+    int16_t x1, int16_t y1,
+    uint32_t f16)
+  {
+    int16_t dx = x1 - x0,
+            dy = y1 - y0,
+            d = abs( dx ) > abs( dy ) ? dx : dy;  // along the major axis
+    uint32_t p = (uint32_t) abs( d ) * f16;
+    // floor rounds away from the start when we're going backwards
+    return ( d >= 0 ? p >> 16 : ( p + q16_one - 1 ) >> 16 ) + 1;
+  }
+
+  // Pixels [from, to) of the Bresenham line from (x0, y0) to (x1, y1).
+  // Consecutive pixels in a row or column go out as one fast line
+  inline void bresenham_range(
     int16_t x0, int16_t y0,
     int16_t x1, int16_t y1,
-    float f,
+    int16_t from, int16_t to,
     uint16_t color,
     Elegoo_TFTLCD *tft)
   {
+    if( from >= to ) return;
     int16_t dx    =  abs( x1 - x0 ), sx = x0 < x1 ? 1 : -1,
             dy    = -abs( y1 - y0 ), sy = y0 < y1 ? 1 : -1, 
-            err   = dx + dy, e2, /* error value e_xy */
-            x_end = x0 + ( x1 - x0 ) * f,  // fractional end point
-            y_end = y0 + ( y1 - y0 ) * f;
-    bool shallow = dx > -dy;
-    for (;;)
+            err   = dx + dy, e2; /* error value e_xy */
+
+    int16_t rx = x0, ry = y0, n = 0;  // the run so far
+    uint8_t run = 0;  // 0: one pixel, could go either way, 1: row, 2: column
+    bool step_x = false, step_y = false;  // how we got to this pixel
+    for ( int16_t i = 0; ; i++ )
     {
-      tft->drawPixel( x0, y0, color );
-      if( shallow )  { if( x0 == x_end ) break; }
-               else  { if( y0 == y_end ) break; }
+      if( i >= from )
+      {
+        if( n && !step_y && run != 2 ) { run = 1; n++; }       // same row
+        else if( n && !step_x && run != 1 ) { run = 2; n++; }  // same column
+        else
+        {
+          if( n ) draw_run( rx, ry, n, run == 1, sx, sy, color, tft );
+          rx = x0; ry = y0; n = 1; run = 0;
+        }
+      }
+      if( i + 1 == to ) break;
       e2 = 2 * err;
-      if (e2 >= dy) { err += dy; x0 += sx; } /* e_xy+e_x > 0 */
-      if (e2 <= dx) { err += dx; y0 += sy; } /* e_xy+e_y < 0 */
+      step_x = e2 >= dy;
+      step_y = e2 <= dx;
+      if (step_x) { err += dy; x0 += sx; } /* e_xy+e_x > 0 */
+      if (step_y) { err += dx; y0 += sy; } /* e_xy+e_y < 0 */
     }
+    draw_run( rx, ry, n, run == 1, sx, sy, color, tft );
+  }
+
+  // KG's modification for Bresenham's algorithm for the radial plot
+  // modified from https://gist.github.com/bert/1085538#file-plot_line-c
+  // The line stops at fraction f16 (Q16) of the way along
+  inline void fractional_bresenham(
+    int16_t x0, int16_t y0,
+    int16_t x1, int16_t y1,
+    uint32_t f16,
+    uint16_t color,
+    Elegoo_TFTLCD *tft)
+  {
+    bresenham_range( x0, y0, x1, y1, 0, bresenham_length( x0, y0, x1, y1, f16 ), color, tft );
   }
 
   // The values are designed so that we can meaningfully AND them
@@ -94,13 +150,78 @@ namespace display {
   #define TWIN        0b101
   #define PALINDROME  0b110
 
+  /*
+    The chart's geometry, worked out by the compiler so there is no float
+    trig on the draw path. sin and cos are Taylor series (C++11 constexpr,
+    so recursion instead of loops). The end points are truncated exactly
+    as the old float code did it, and stored as offsets from the chart
+    center, which fit in an int8_t. That's 8 bytes a slot, in flash on the
+    Uno. The Bresenham set up (dx, dy, steps) is a couple of subtractions
+    from these, so we don't store it.
+  */
+  constexpr double trig_series( double x2, double term, double sum, int k )
+  {
+    return k > 40 ? sum : trig_series( x2, -term * x2 / ( ( k + 1 ) * ( k + 2 ) ), sum + term, k + 2 );
+  }
+
+  constexpr double wrap_angle( double x ) { return x > M_PI ? x - 2 * M_PI : x; }
+  constexpr double const_sin( double x ) { return trig_series( wrap_angle( x ) * wrap_angle( x ), wrap_angle( x ), 0, 1 ); }
+  constexpr double const_cos( double x ) { return trig_series( wrap_angle( x ) * wrap_angle( x ), 1, 0, 0 ); }
+
+  constexpr float slot_theta( unsigned slot ) { return D_THETA * (float) slot; }
+
+  // Point at radius r on the spoke for this slot, relative to the center
+  constexpr int8_t spoke_dx( unsigned slot, int r )
+  {
+    return (int) ( CHART_X + r * (float) const_sin( slot_theta( slot ) ) ) - ( CHART_X );
+  }
+  constexpr int8_t spoke_dy( unsigned slot, int r )
+  {
+    return (int) ( CHART_Y - r * (float) const_cos( slot_theta( slot ) ) ) - ( CHART_Y );
+  }
+
+  struct SpokeEnds { int8_t x0, y0, x1, y1; };
+
+  template <typename I = MakeIndices<CHART_N>::type>
+  struct ChartGeometry;
+
+  template <unsigned... I>
+  struct ChartGeometry<Indices<I...> >
+  {
+    static const SpokeEnds bar[ CHART_N ],     // CHART_R0 .. CHART_R0 + CHART_DR
+                           cursor[ CHART_N ];  // CHART_BASE_R0 .. CHART_BASE_R1
+  };
+
+  template <unsigned... I>
+  const SpokeEnds ChartGeometry<Indices<I...> >::bar[ CHART_N ] PRIMES_PROGMEM = {
+    { spoke_dx( I, CHART_R0 ), spoke_dy( I, CHART_R0 ),
+      spoke_dx( I, CHART_R0 + CHART_DR ), spoke_dy( I, CHART_R0 + CHART_DR ) }...
+  };
+
+  template <unsigned... I>
+  const SpokeEnds ChartGeometry<Indices<I...> >::cursor[ CHART_N ] PRIMES_PROGMEM = {
+    { spoke_dx( I, CHART_BASE_R0 ), spoke_dy( I, CHART_BASE_R0 ),
+      spoke_dx( I, CHART_BASE_R1 ), spoke_dy( I, CHART_BASE_R1 ) }...
+  };
+
+  inline SpokeEnds read_spoke( const SpokeEnds *table, uint16_t slot )
+  {
+    SpokeEnds e;
+    primes_read_block( &e, &table[ slot ], sizeof( e ) );
+    return e;
+  }
+
+  // A bar's length runs 0 (nothing drawn) .. CHART_DR + 1 pixels
+  #define BAR_LENGTHS ( CHART_DR + 2 )
+
   struct RadialChart
   {
     Elegoo_TFTLCD *tft;              // This is the pysical display    
+    uint8_t bars[ CHART_N ];         // What each slot shows: color index * BAR_LENGTHS + length
     void init(Elegoo_TFTLCD *_tft);  // Draw fixed elements of the display
-    void draw( prime_t m, float f, byte m_type );
-    void cursor( float theta, uint16_t color );    
-    void radial_line( float theta, float f, uint16_t color );
+    void draw( prime_t m, uint32_t f16, byte m_type );
+    void cursor( uint16_t slot, uint16_t color );    
+    void radial_line( uint16_t slot, uint32_t f16, uint8_t color_index );
   };
   
   struct DigitDisplay
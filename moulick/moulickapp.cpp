@@ -1,4 +1,5 @@
 #include "moulickapp.h"
+#include "clock_snapshots.h"
 
 namespace moulickapp
 {
@@ -7,6 +8,16 @@ namespace moulickapp
   {
     tft = new Elegoo_TFTLCD(LCD_CS, LCD_CD, LCD_WR, LCD_RD, LCD_RESET);
     pc = new PrimeClock();
+
+    // Pick up where we were before the power went
+    checkpoints = new Checkpointer( EepromStorage() );
+    ClockSnapshot s;
+    if( checkpoints->load( s ) ) pc->restore( s );
+    last_checkpoint = millis();
+
+    poll_touch = nullptr;
+    frame = 0;
+    frame_deadline = millis() + FRAME_MS;
     initialize_display();
   }
 
@@ -17,15 +28,18 @@ namespace moulickapp
     tft->setRotation(1);  // Landscape, with the Uno's USB port to the right
 
     enable_refresh = false;
+    redraw_pending = false;
     switch_to( Screen::Corona );
   }
 
+  // The redraw itself waits for its turn in next_tick
   void MoulickApp::toggle_screen()
   {
     if( screen_to_display == Screen::Corona )
-      switch_to( Screen::Stats );
+      screen_to_display = Screen::Stats;
     else
-      switch_to( Screen::Corona );
+      screen_to_display = Screen::Corona;
+    redraw_pending = true;
   }
 
   void MoulickApp::switch_to( Screen scr )
@@ -43,14 +57,61 @@ namespace moulickapp
     }
   }
 
+  /*
+    One frame of the main loop. The tasks, highest priority first:
+
+      touch poll      - once a frame
+      full redraw     - when asked for (new screen, new m), runs to the end
+      partial redraw  - every REDRAW_PERIOD frames, if a test is under way
+      prime work      - TEST_SLICE at a time until the frame deadline
+
+    Nothing draws from an interrupt anymore, so the drawing code never
+    races with itself and the timer ticks aren't held up by long redraws
+  */
   void MoulickApp::next_tick()
   {
-    enable_refresh = true;  // We only need the partial refresh when we are in this blocking loop
-    pc->check_next();
-    enable_refresh = false;
-    
-    noInterrupts();
-    // We may get glitches if we don't stop any background drawing routine
+    frame++;
+
+    if( poll_touch ) poll_touch( *this );
+
+    if( redraw_pending )
+    {
+      redraw_pending = false;
+      switch_to( screen_to_display );
+    }
+    else if( frame % REDRAW_PERIOD == 0 )
+      refresh_display();
+
+    do_prime_work();
+
+    // If a redraw ran long we don't try to catch up, we just start afresh
+    frame_deadline += FRAME_MS;
+    if( (long) ( millis() - frame_deadline ) > 0 ) frame_deadline = millis() + FRAME_MS;
+  }
+
+  // Test numbers until the frame is up. A number that is not done carries
+  // over to the next frame
+  void MoulickApp::do_prime_work()
+  {
+    while( (long) ( millis() - frame_deadline ) < 0 )
+    {
+      if( !enable_refresh )
+      {
+        pc->start_next();
+        enable_refresh = true;
+      }
+      if( !pc->resume_next( TEST_SLICE ) ) continue;
+      enable_refresh = false;
+      if( pc->pt.k == 0 ) continue;  // Aborted by a new m, the redraw is coming
+      // Only between numbers: mid test, m is already the one being tested
+      // and restore() would skip it
+      if( millis() - last_checkpoint > CHECKPOINT_PERIOD_MS ) save_checkpoint();
+      draw();
+    }
+  }
+
+  void MoulickApp::draw()
+  {
     switch( screen_to_display )
     {
       case Screen::Corona:
@@ -61,12 +122,10 @@ namespace moulickapp
         stats_disp.draw();
         break;
     }
-    interrupts();
   }
 
-  // We call this periodically (say using an interrupt) to animate the
-  // display when prime testing is taking long and the display would
-  // otherwise look frozen
+  // We call this periodically to animate the display when prime testing
+  // is taking long and the display would otherwise look frozen
   void MoulickApp::refresh_display()
   {
     if( !enable_refresh ) return;
@@ -82,10 +141,24 @@ namespace moulickapp
     }
   }
 
+  void MoulickApp::save_checkpoint()
+  {
+    ClockSnapshot s;
+    pc->snapshot( s );
+    checkpoints->save( s );
+    last_checkpoint = millis();
+  }
+
   void MoulickApp::set_new_m( prime_t m)
   {
-    pc->restart_clock_from( m );
-    switch_to( screen_to_display );
+    // The touch screen start points are all in the snapshot table, so we
+    // keep the full stats. Anything else starts counting from m
+    ClockSnapshot s;
+    if( find_clock_snapshot( m, s ) )
+      pc->restore( s );
+    else
+      pc->restart_clock_from( m );
+    redraw_pending = true;
   }
 
 }
\ No newline at end of file
@@ -2,29 +2,56 @@
   Ties all the components together
 */
 #include "display.h"
+#include "checkpoint.h"
+
+// How often we save the clock to EEPROM. Each slot is good for ~100k
+// writes, and we alternate between two, so this is years of wear
+#define CHECKPOINT_PERIOD_MS ( 10UL * 60 * 1000 )
+
+// Divisor pairs we test before coming up for air. ~1 ms on the Uno
+#define TEST_SLICE 64
+
+// The main loop runs in frames. Each frame the tasks get their turn in
+// priority order (see next_tick) and prime testing has what is left
+#define FRAME_MS 62       // ~16 Hz, the rate the touch screen ISR used to poll at
+#define REDRAW_PERIOD 4   // A partial redraw every 4th frame
 
 namespace moulickapp
 {
   using namespace display;
+  using namespace checkpoint;
+
+  struct MoulickApp;
+  typedef void (*TouchPoll)( MoulickApp& );  // Reads the touch screen, acts on it
 
   struct MoulickApp
   {
     Elegoo_TFTLCD *tft;  
     PrimeClock *pc;
+    Checkpointer *checkpoints;
+    unsigned long last_checkpoint;  // millis()
     
     Clock corona_disp;
     Stats stats_disp;
     enum class Screen{Corona=0, Stats};
     Screen screen_to_display;
-    bool enable_refresh;
+    bool enable_refresh;   // A number is part way through testing
+    bool redraw_pending;   // The screen needs a full redraw
+
+    TouchPoll poll_touch;
+    unsigned long frame_deadline;  // millis()
+    uint8_t frame;
 
     void init();
     void initialize_display();
     void toggle_screen();
     void switch_to( Screen scr );    
-    void next_tick();
+    void next_tick();  // One frame
+    void do_prime_work();
+    void draw();
     void refresh_display(); // A partial redraw when prime testing is taking long  
     void set_new_m( prime_t m);
+    void save_checkpoint();
   };
 
 }
@@ -0,0 +1,181 @@
+/*
+  Division free pre-filtering of candidates against a table of small primes.
+
+  Most composites have a small factor. Rather than finding that out with a
+  hardware % (or, on the Uno, a software division) we use the fact that for
+  odd p and w bit unsigned m
+
+    p divides m  <=>  m * inv(p) <= (2^w - 1) / p   (mod 2^w)
+
+  where inv(p) is the inverse of p mod 2^w. That is one multiply and one
+  compare per prime, and it vectorizes: with AVX2 we test eight 32 bit
+  numbers against a prime per instruction pair.
+*/
+#ifndef _PREFILTER_H_
+#define _PREFILTER_H_
+
+#include "primes.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace primes {
+
+  // One Newton step x -> x * ( 2 - p * x ) doubles the number of correct low
+  // bits of the inverse of p mod 2^w
+  template <typename T>
+  constexpr T newton_inverse( T p, T x, unsigned steps )
+  {
+    return steps == 0 ? x : newton_inverse<T>( p, (T) ( x * ( (T) 2 - p * x ) ), steps - 1 );
+  }
+
+  // x = p is already right for the low 3 bits, so six steps give 192 bits,
+  // which covers every width we support
+  template <typename T>
+  constexpr T inverse_mod_2w( T p ) { return newton_inverse<T>( p, p, 6 ); }
+
+  // The odd primes below 256
+  #define SMALL_ODD_PRIMES \
+      3,   5,   7,  11,  13,  17,  19,  23,  29,  31,  37,  41,  43,  47,  53,  59, \
+     61,  67,  71,  73,  79,  83,  89,  97, 101, 103, 107, 109, 113, 127, 131, 137, \
+    139, 149, 151, 157, 163, 167, 173, 179, 181, 191, 193, 197, 199, 211, 223, 227, \
+    229, 233, 239, 241, 251
+
+  const uint8_t n_small_odd_primes = 53;
+  const uint8_t max_small_prime = 251;
+
+  template <typename T, unsigned... P>
+  struct BasicDivisibilityTable
+  {
+    static_assert( sizeof( T ) >= 4, "Needs at least 32 bit arithmetic" );
+    static constexpr T inv[ sizeof...( P ) ] = { inverse_mod_2w<T>( P )... };
+    static constexpr T lim[ sizeof...( P ) ] = { (T) ~(T) 0 / P... };
+  };
+
+  template <typename T, unsigned... P>
+  constexpr T BasicDivisibilityTable<T, P...>::inv[];
+  template <typename T, unsigned... P>
+  constexpr T BasicDivisibilityTable<T, P...>::lim[];
+
+  template <typename T>
+  struct DivisibilityTable : BasicDivisibilityTable<T, SMALL_ODD_PRIMES> {};
+
+  #undef SMALL_ODD_PRIMES
+
+  // Does m have a factor below 256 (m itself may be that factor)?
+  template <typename T>
+  inline bool has_small_factor( T m )
+  {
+    typedef DivisibilityTable<T> table;
+    if( m % 2 == 0 ) return true;
+    for( uint8_t j = 0; j < n_small_odd_primes; j++ )
+      if( (T) ( m * table::inv[ j ] ) <= table::lim[ j ] ) return true;
+    return false;
+  }
+
+  /*
+    Batch API: small[ i ] = has_small_factor( m[ i ] ) for i in [0, n).
+    A 1 means m[ i ] is composite unless m[ i ] <= max_small_prime.
+  */
+  template <typename T>
+  inline void small_factor_batch( const T *m, uint16_t n, uint8_t *small )
+  {
+    for( uint16_t i = 0; i < n; i++ ) small[ i ] = has_small_factor( m[ i ] );
+  }
+
+#ifdef __AVX2__
+  // Eight lanes at a time, with the scalar loop picking up the tail
+  template <>
+  inline void small_factor_batch<uint32_t>( const uint32_t *m, uint16_t n, uint8_t *small )
+  {
+    typedef DivisibilityTable<uint32_t> table;
+    const __m256i one = _mm256_set1_epi32( 1 ),
+                  zero = _mm256_setzero_si256();
+    uint16_t i = 0;
+    for( ; i + 8 <= n; i += 8 )
+    {
+      __m256i v = _mm256_loadu_si256( (const __m256i*) ( m + i ) ),
+              hit = _mm256_cmpeq_epi32( _mm256_and_si256( v, one ), zero );  // even
+      for( uint8_t j = 0; j < n_small_odd_primes; j++ )
+      {
+        __m256i prod = _mm256_mullo_epi32( v, _mm256_set1_epi32( (int) table::inv[ j ] ) ),
+                lim = _mm256_set1_epi32( (int) table::lim[ j ] );
+        // prod <= lim (unsigned) <=> min( prod, lim ) == prod
+        hit = _mm256_or_si256( hit, _mm256_cmpeq_epi32( _mm256_min_epu32( prod, lim ), prod ) );
+      }
+      int mask = _mm256_movemask_ps( _mm256_castsi256_ps( hit ) );
+      for( uint8_t b = 0; b < 8; b++ ) small[ i + b ] = ( mask >> b ) & 1;
+    }
+    for( ; i < n; i++ ) small[ i ] = has_small_factor( m[ i ] );
+  }
+#endif
+
+  // How many numbers the PrefilterTester looks ahead by
+  const uint8_t prefilter_block = 16;
+
+  /*
+    Wraps another tester. Numbers are pre-filtered in blocks of
+    prefilter_block with small_factor_batch(), on the assumption that the
+    clock asks about consecutive numbers. Anything with a small factor is
+    rejected right away (an empty bar, k = 1), everything else goes to the
+    wrapped tester. We inherit from it so that k, k_max and abrt are the
+    wrapped tester's own and can be watched while it runs.
+  */
+  template <typename T, typename Inner = BasicPrimeTester<T> >
+  struct BasicPrefilterTester : Inner
+  {
+    T block[ prefilter_block ];
+    uint8_t small[ prefilter_block ];
+    bool block_valid,
+         filtered;  // the m start() was given had a small factor
+
+    BasicPrefilterTester() { block_valid = false; filtered = false; }
+
+    bool is_prime( T m )
+    {
+      if( filter( m ) ) return false;
+      return Inner::is_prime( m );
+    }
+
+    // The sliced version, see PrimeTester::start()
+    void start( T m )
+    {
+      filtered = filter( m );
+      if( filtered ) this->verdict = false;
+      else Inner::start( m );
+    }
+
+    template <typename U>
+    bool resume( U budget )
+    {
+      if( filtered ) return true;
+      return Inner::resume( budget );
+    }
+
+    // True (with an empty bar) if m has a small factor
+    bool filter( T m )
+    {
+      if( !block_valid || m < block[ 0 ] || m - block[ 0 ] >= prefilter_block ) fill_block( m );
+      if( m > max_small_prime && small[ m - block[ 0 ] ] )
+      {
+        this->k = 1;
+        this->k_max = 1;
+        return true;
+      }
+      return false;
+    }
+
+    void fill_block( T m )
+    {
+      for( uint8_t i = 0; i < prefilter_block; i++ ) block[ i ] = m + i;
+      small_factor_batch( block, prefilter_block, small );
+      block_valid = true;
+    }
+  };
+
+  typedef BasicPrefilterTester<prime_t> PrefilterTester;
+
+}
+
+#endif // _PREFILTER_H_
@@ -4,9 +4,44 @@
 #ifndef _PRIMES_H_
 #define _PRIMES_H_
 
+#include <stdint.h>
+#include <string.h>
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#endif
 
 namespace primes {
 
+  // Number of decimal digits needed to print m
+  template <typename T>
+  constexpr unsigned char n_digits( T m ) { return m < 10 ? 1 : 1 + n_digits<T>( m / 10 ); }
+
+  /*
+    Per width constants. This is only defined for the unsigned integer types
+    we allow as prime numbers, which also keeps the integer templates below
+    from matching anything else (like a char *)
+  */
+  template <typename T> struct PrimeTraits;
+
+  #define PRIMES_TRAITS( T ) \
+    template <> struct PrimeTraits<T> \
+    { \
+      typedef T type; \
+      static constexpr unsigned char max_digits = n_digits<T>( (T) ~(T) 0 ); \
+    };
+
+  PRIMES_TRAITS( unsigned char )
+  PRIMES_TRAITS( unsigned short )
+  PRIMES_TRAITS( unsigned int )
+  PRIMES_TRAITS( unsigned long )
+  PRIMES_TRAITS( unsigned long long )
+#ifdef __SIZEOF_INT128__
+  typedef unsigned __int128 uint128_t;
+  PRIMES_TRAITS( uint128_t )
+#endif
+
+  #undef PRIMES_TRAITS
+
   /*
     I debated whether to make this uint32_t (which takes us to four billion)
     or uint64_t (which take us to eighteen quintillion).
@@ -29,18 +64,23 @@ namespace primes {
     Interestingly, I did not measure any difference in performance between using
     uint32_t and uint64_t, which was strange. This being a 8 bit microcontroller
     uint64_t should take twice as long as uint32_t computations. 
+
+    Everything below is templated on the integer type, so prime_t is just the
+    width the device runs with. Host code can use BasicPrimeClock<uint64_t>
+    (or uint128_t) alongside it.
   */
-  // typedef unsigned long long prime_t;  // prime number type
-  // const unsigned char p_max_d = 20;  // log10(2^64 -1)
+  // typedef uint64_t prime_t;  // prime number type
   typedef uint32_t prime_t;  // prime number type
-  const unsigned char p_max_d = 10;  // log10(2^32 -1)
+  const unsigned char p_max_d = PrimeTraits<prime_t>::max_digits;  // digits in the largest prime_t
 
 
-  // buf should have size p_max_d + 1 and end in '\0'
-  inline char* prime_t_to_str( prime_t m, char *buf )
+  // buf should have size PrimeTraits<T>::max_digits + 1 and end in '\0'
+  template <typename T>
+  inline char* prime_t_to_str( T m, char *buf )
   {
-    char *m_ptr = buf + p_max_d;
-    for(int i = 0 ; i < p_max_d ; i++)
+    const unsigned char max_d = PrimeTraits<T>::max_digits;
+    char *m_ptr = buf + max_d;
+    for(int i = 0 ; i < max_d ; i++)
     {
       m_ptr--;
       *m_ptr = (char) (m % 10 + 48);  // Convert remainder to ASCII for 0, 1, 2....
@@ -52,16 +92,30 @@ namespace primes {
   }
 
 
-  // Good enough code for finding the square root of m
-  // We only need to check divisors up to this
-  inline prime_t sqrt( prime_t m )
+  // Exact integer square root: the largest r with r * r <= m
+  // We only need to check divisors up to this. Digit by digit in base 4, so
+  // no division and no floats (which lose precision above 2^24)
+  template <typename T>
+  inline T isqrt( T m )
   {
-      float sqrt_m = m;
-      for( int i = 0; i < 6; i++ )
-          sqrt_m = (sqrt_m * sqrt_m + m) / (2 * sqrt_m);
-      return (prime_t) sqrt_m;
+    T r = 0,
+      bit = (T) 1 << ( 8 * sizeof( T ) - 2 );
+    while( bit > m ) bit >>= 2;
+    for( ; bit; bit >>= 2 )
+    {
+      if( m >= r + bit )
+      {
+        m -= r + bit;
+        r = ( r >> 1 ) + bit;
+      }
+      else
+        r >>= 1;
+    }
+    return r;
   }
 
+  inline prime_t sqrt( prime_t m ) { return isqrt( m ); }
+
   
   inline bool is_palindrome( const char *buf )
   {
@@ -73,6 +127,17 @@ namespace primes {
     return true;
   }
 
+  template <typename T>
+  inline bool is_palindrome( T m, typename PrimeTraits<T>::type * = 0 )
+  {
+    char buf[ PrimeTraits<T>::max_digits + 1 ];
+    buf[ PrimeTraits<T>::max_digits ] = '\0';
+    return is_palindrome( (const char*) prime_t_to_str( m, buf ) );
+  }
+
+  inline int first_digit( const char *buf ) { return buf[ 0 ] - '0'; }
+  inline int last_digit( const char *buf ) { return buf[ strlen( buf ) - 1 ] - '0'; }
+
   
   /*
     We structure the prime tester as a struct and expose
@@ -80,15 +145,17 @@ namespace primes {
     operation and peek into how many factors have been
     tested if we so wish
   */
-  struct PrimeTester
+  template <typename T>
+  struct BasicPrimeTester
   {
-    prime_t k_max,  // number of factors to check in total
-            k;      // number of factors already checked
+    T k_max,  // number of factors to check in total
+      k;      // number of factors already checked
     volatile bool abrt;  // flag used by external interrupt to break our routine
                          // needs to be declared volatile, otherwise ISR won't be
                          // able to change the value the PrimeTester loop is seeing
+    uint32_t divisions;  // % done on the current m, for the benchmarks
 
-    PrimeTester() { k = 0; k_max = 1; abrt = false; }
+    BasicPrimeTester() { k = 0; k_max = 1; abrt = false; running = false; verdict = false; m_testing = 0; divisions = 0; }
 
     // https://en.wikipedia.org/wiki/Primality_test
     // Implemented as a member function so that we can set the
@@ -96,69 +163,1217 @@ namespace primes {
     // variables. This allows us to show the internal progress
     // of the prime test if we pause the function 
     // (e.g. via an interrupt)
-    bool is_prime( prime_t m )
+    bool is_prime( T m )
+    {
+      start( m );
+      resume( k_max );  // enough for the whole test
+      return verdict;
+    }
+
+    /*
+      The same test in slices: start( m ), then resume( budget ) tries up
+      to budget pairs of divisors a call and returns true when the test is
+      over, with the answer in verdict. k carries over between calls, so
+      fraction tested still works in between. Calling start() again with
+      the m we are in the middle of carries on from where we were.
+
+      Setting abrt (or calling cancel()) ends the test with k = 0
+    */
+    T m_testing;   // the m being tested
+    bool running,  // part way through m_testing
+         verdict;  // the answer, once resume() returns true
+
+    void start( T m )
     {
+      if( running && m == m_testing ) return;  // carry on where we were
       abrt = false;
-            
+      m_testing = m;
+      running = false;
+
       k = 1;
       k_max = 1;
+      divisions = 0;
       
-      if( m == 2 | m == 3 ) return true;
+      if( m == 2 | m == 3 ) { verdict = true; return; }
   
-      if( m % 2 == 0 ) return false;
-      if( m % 3 == 0 ) return false;
+      divisions++;
+      if( m % 2 == 0 ) { verdict = false; return; }
+      divisions++;
+      if( m % 3 == 0 ) { verdict = false; return; }
       
-      prime_t k6;
-          
-      k_max = (sqrt(m) + 1) / 6;
-      for( k = 1; k <= k_max; k++ )  // divisible by 6*k +/- 1 ?
+      k_max = (isqrt(m) + 1) / 6;
+      running = true;
+    }
+
+    bool resume( T budget )
+    {
+      if( !running ) return true;
+
+      T k6;
+      for( ; k <= k_max; k++ )  // divisible by 6*k +/- 1 ?
       {
         if( abrt ) // Stop work and get out.
         {
-          k = 0; // Hack to avoid printing a spurious bar
-          return false;  
+          cancel();
+          return true;
         }
+        if( budget-- == 0 ) return false;  // More next time
         k6 = 6 * k;
-        if( m % (k6 - 1) == 0 ) return false;
-        if( m % (k6 + 1) == 0 ) return false;      
+        divisions++;
+        bool divisible = m_testing % (k6 - 1) == 0;
+        if( !divisible )
+        {
+          divisions++;
+          divisible = m_testing % (k6 + 1) == 0;
+        }
+        if( divisible )
+        {
+          running = false;
+          verdict = false;
+          return true;
+        }
       }
-  
+
+      running = false;
+      verdict = true;
+      return true;
+    }
+
+    void cancel()
+    {
+      running = false;
+      verdict = false;
+      k = 0; // Hack to avoid printing a spurious bar
+    }
+  };
+
+  typedef BasicPrimeTester<prime_t> PrimeTester;
+
+  /*
+    PrimeTester's start()/resume()/verdict for the testers that can't stop
+    part way: start() runs the whole test and resume() just says it is
+    over. Lets the clock's sliced path (start_next/resume_next) run with
+    any tester. Derived is the tester itself
+  */
+  template <typename Derived>
+  struct OneShot
+  {
+    bool verdict;
+
+    template <typename U>
+    void start( U m ) { verdict = static_cast<Derived*>( this )->is_prime( m ); }
+
+    template <typename U>
+    bool resume( U ) { return true; }
+  };
+
+
+  /*
+    Wheel factorization. The numbers coprime to W = 2 * 3 * 5 (* 7) repeat
+    with period W, so once we have checked the primes in W we only need to
+    try divisors that land on one of these "spokes". 6k +/- 1 is the W = 6
+    wheel and tries 1/3 of all numbers, W = 30 tries 8/30 and W = 210 tries
+    48/210.
+
+    The spokes and the gaps between them are generated at compile time.
+    Everything here is C++11 constexpr (single return statements and
+    recursion) because that is what the Arduino toolchain compiles with.
+  */
+  constexpr unsigned gcd( unsigned a, unsigned b ) { return b == 0 ? a : gcd( b, a % b ); }
+
+  // How many n in [n0, W] are coprime to W
+  constexpr unsigned totient( unsigned W, unsigned n0 = 1 )
+  {
+    return n0 > W ? 0 : ( gcd( n0, W ) == 1 ) + totient( W, n0 + 1 );
+  }
+
+  // The i-th number >= n0 that is coprime to W
+  constexpr unsigned wheel_spoke( unsigned W, unsigned i, unsigned n0 = 1 )
+  {
+    return gcd( n0, W ) != 1 ? wheel_spoke( W, i, n0 + 1 ) :
+           i == 0 ? n0 : wheel_spoke( W, i - 1, n0 + 1 );
+  }
+
+  // Distance from spoke i to the next one, wrapping around to 1 + W
+  constexpr unsigned wheel_gap( unsigned W, unsigned i )
+  {
+    return ( i + 1 == totient( W ) ? W + 1 : wheel_spoke( W, i + 1 ) ) - wheel_spoke( W, i );
+  }
+
+  // A C++11 stand in for std::index_sequence
+  template <unsigned... I> struct Indices {};
+  template <unsigned N, unsigned... I> struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+  template <unsigned... I> struct MakeIndices<0, I...> { typedef Indices<I...> type; };
+
+  template <unsigned W, typename I = typename MakeIndices<totient( W )>::type>
+  struct Wheel;
+
+  template <unsigned W, unsigned... I>
+  struct Wheel<W, Indices<I...> >
+  {
+    static_assert( W == 6 || W == 30 || W == 210, "Wheel must be 6, 30 or 210" );
+    static constexpr unsigned n_spokes = sizeof...( I );
+    static constexpr uint8_t spoke[ sizeof...( I ) ] = { wheel_spoke( W, I )... };
+    static constexpr uint8_t gap[ sizeof...( I ) ] = { wheel_gap( W, I )... };
+  };
+
+  template <unsigned W, unsigned... I>
+  constexpr uint8_t Wheel<W, Indices<I...> >::spoke[];
+  template <unsigned W, unsigned... I>
+  constexpr uint8_t Wheel<W, Indices<I...> >::gap[];
+
+  /*
+    Trial division over a wheel. Same interface as PrimeTester. k counts
+    single divisors (PrimeTester counts pairs) and k_max is worked out
+    exactly from the wheel, so a prime still ends with k = k_max + 1.
+  */
+  template <typename T, unsigned W = 210>
+  struct BasicWheelTester : OneShot< BasicWheelTester<T, W> >
+  {
+    typedef Wheel<W> wheel;
+
+    T k_max,  // number of divisors to check in total
+      k;      // number of divisors already checked
+    volatile bool abrt;
+    uint32_t divisions;  // % done on the last m, for the benchmarks
+
+    BasicWheelTester() { k = 0; k_max = 1; abrt = false; divisions = 0; }
+
+    // How many spokes, not counting 1, are there in [1, x]
+    static T n_divisors( T x )
+    {
+      T n = ( x / W ) * wheel::n_spokes;
+      unsigned r = x % W;
+      for( unsigned i = 0; i < wheel::n_spokes && wheel::spoke[ i ] <= r; i++ ) n++;
+      return n - 1;
+    }
+
+    bool is_prime( T m )
+    {
+      static const uint8_t basis[] = { 2, 3, 5, 7 };
+
+      abrt = false;
+
+      k = 1;
+      k_max = 1;
+      divisions = 0;
+
+      if( m < 2 ) return false;
+      for( uint8_t i = 0; i < 4; i++ )
+      {
+        if( W % basis[ i ] ) break;
+        if( m == basis[ i ] ) return full_bar();
+        divisions++;
+        if( m % basis[ i ] == 0 ) return false;
+      }
+
+      T s = isqrt( m );
+      if( s < wheel::spoke[ 1 ] ) return full_bar();  // Nothing left to divide by
+
+      k_max = n_divisors( s );
+      T d = wheel::spoke[ 1 ];
+      unsigned i = 1;
+      for( k = 1; k <= k_max; k++ )
+      {
+        if( abrt )
+        {
+          k = 0; // Same hack as in PrimeTester
+          return false;
+        }
+        divisions++;
+        if( m % d == 0 ) return false;
+        d += wheel::gap[ i ];
+        if( ++i == wheel::n_spokes ) i = 0;
+      }
+
+      return true;
+    }
+
+    bool full_bar()
+    {
+      k = 2;  // (k - 1) / k_max = 1
+      return true;
+    }
+  };
+
+  typedef BasicWheelTester<prime_t> WheelTester;
+
+
+  /*
+    Trial division without the division, for a clock that steps by one.
+
+    We keep m mod p for every odd prime p with p * p <= m. Going from m to
+    m + 1 each residue just goes up by one and wraps to 0 at p, and m is
+    divisible by p exactly when its residue is 0. A prime joins the table
+    at m = p * p, where its residue is 0 by definition. So on the hot path
+    there is only increment, compare and reset.
+
+    The table holds the first N odd primes. If sqrt(m) outgrows it we fall
+    back to dividing by the odd numbers beyond the last table prime.
+    A jump (anything other than m + 1) costs one % per live prime to
+    recompute the residues.
+
+    k is the position of the first divisor found, k_max the number of
+    divisors for this m, as in the other testers.
+  */
+  template <typename T, uint16_t N>
+  struct BasicResidueTester : OneShot< BasicResidueTester<T, N> >
+  {
+    T k_max,
+      k;
+    volatile bool abrt;
+
+    T p[ N ],   // the first N odd primes
+      r[ N ],   // r[ i ] = m mod p[ i ] for the live primes
+      m_last,   // the m the residues are for
+      next_square;  // p[ n_live ]^2, when that prime goes live
+    uint16_t n_live;  // primes with p * p <= m_last
+    bool synced,
+         more;    // is there a prime left to go live?
+
+    BasicResidueTester()
+    {
+      k = 0; k_max = 1; abrt = false;
+      synced = false;
+      n_live = 0;
+
+      // Fill the table by trial division against what we have so far
+      uint16_t n = 0;
+      for( T c = 3; n < N; c += 2 )
+      {
+        bool c_is_prime = true;
+        for( uint16_t i = 0; i < n && p[ i ] * p[ i ] <= c; i++ )
+          if( c % p[ i ] == 0 ) { c_is_prime = false; break; }
+        if( c_is_prime ) p[ n++ ] = c;
+      }
+    }
+
+    // Work out when the next prime in the table goes live
+    void next_to_go_live()
+    {
+      more = n_live < N && p[ n_live ] <= isqrt( (T) ~(T) 0 );
+      if( more ) next_square = p[ n_live ] * p[ n_live ];
+    }
+
+    // Recompute everything for an arbitrary m. This is the only place we divide
+    void resync( T m )
+    {
+      for( n_live = 0; n_live < N && p[ n_live ] <= m / p[ n_live ]; n_live++ )
+        r[ n_live ] = m % p[ n_live ];
+      next_to_go_live();
+      m_last = m;
+      synced = true;
+    }
+
+    // Step the residues on to m = m_last + 1 and return the index of the
+    // first prime that divides m (n_live if none does)
+    uint16_t step()
+    {
+      const T m = ++m_last;
+      uint16_t first = n_live;
+      for( uint16_t i = 0; i < n_live; i++ )
+      {
+        if( ++r[ i ] == p[ i ] ) r[ i ] = 0;
+        if( r[ i ] == 0 && first == n_live ) first = i;
+      }
+      if( more && m == next_square )
+      {
+        // p * p is divisible by p, of course
+        r[ n_live ] = 0;
+        n_live++;
+        next_to_go_live();
+      }
+      return first;
+    }
+
+    bool is_prime( T m )
+    {
+      abrt = false;
+
+      k = 1;
+      k_max = 1;
+
+      uint16_t first;
+      if( synced && m == m_last + 1 ) first = step();
+      else
+      {
+        resync( m );
+        for( first = 0; first < n_live && r[ first ] != 0; first++ );
+      }
+
+      if( m < 2 ) return false;
+      if( m == 2 ) return full_bar();
+      if( ( m & 1 ) == 0 ) return false;
+
+      // Odd divisors past the table, if sqrt(m) has outgrown it
+      T s = isqrt( m ),
+        d0 = p[ N - 1 ] + 2,
+        n_extra = ( n_live == N && s >= d0 ) ? ( s - d0 ) / 2 + 1 : 0;
+
+      k_max = n_live + n_extra;
+      if( k_max == 0 )
+      {
+        k_max = 1;
+        return full_bar();  // Nothing to divide by
+      }
+      if( first < n_live )
+      {
+        k = first + 1;
+        return false;
+      }
+
+      k = n_live + 1;
+      for( T d = d0; n_extra; n_extra--, d += 2, k++ )
+      {
+        if( abrt )
+        {
+          k = 0; // Same hack as in PrimeTester
+          return false;
+        }
+        if( m % d == 0 ) return false;
+      }
+
+      return true;
+    }
+
+    bool full_bar()
+    {
+      k = 2;  // (k - 1) / k_max = 1
+      return true;
+    }
+  };
+
+  // 6542 odd primes covers sqrt of all of uint32_t, but that is 52 kB. On
+  // the Uno the table has to be much smaller and we fall back to division
+  // once m passes 317^2
+#ifdef __AVR__
+  typedef BasicResidueTester<prime_t, 64> ResidueTester;
+#else
+  typedef BasicResidueTester<prime_t, 6542> ResidueTester;
+#endif
+
+
+  /*
+    Trial division by primes only.
+
+    PrimeTester divides by every 6k +/- 1, which includes 25, 35, 49 ...
+    Here the odd primes below 2^16 are worked out by the compiler and we
+    only divide by those. That covers sqrt of all of uint32_t. For wider
+    types we carry on with odd divisors past the table.
+
+    The table is stored as half gaps, one byte per prime (the biggest gap
+    below 2^16 is 72), plus every 64th prime so we can count the primes up
+    to sqrt(m) for k_max without walking the whole table. That is ~6.7 kB
+    and on the Uno it goes in flash (PROGMEM).
+
+    The generator needs C++14 constexpr (loops), so on the Uno build with
+    -std=gnu++14 to use this tester.
+  */
+#ifdef __AVR__
+#define PRIMES_PROGMEM PROGMEM
+#define primes_read_byte( p ) pgm_read_byte( p )
+#define primes_read_word( p ) pgm_read_word( p )
+#define primes_read_block( dst, src, n ) memcpy_P( dst, src, n )
+#else
+#define PRIMES_PROGMEM
+#define primes_read_byte( p ) ( *(const uint8_t*) ( p ) )
+#define primes_read_word( p ) ( *(const uint16_t*) ( p ) )
+#define primes_read_block( dst, src, n ) memcpy( dst, src, n )
+#endif
+
+#if __cplusplus >= 201402L
+  const uint16_t n_table_odd_primes = 6541,  // 3, 5, 7 ... 65521
+                 small_prime_stride = 64,
+                 n_small_prime_checkpoints = ( n_table_odd_primes + small_prime_stride - 1 ) / small_prime_stride;
+
+  struct SmallPrimeTable
+  {
+    uint8_t half_gap[ n_table_odd_primes ];  // ( p[ i + 1 ] - p[ i ] ) / 2, last one 0
+    uint16_t checkpoint[ n_small_prime_checkpoints ];  // p[ 64 * j ]
+  };
+
+  // Sieve of Eratosthenes, at compile time
+  constexpr SmallPrimeTable make_small_prime_table()
+  {
+    SmallPrimeTable t{};
+    bool composite[ 32768 ] = {};  // composite[ i ] is for 2 * i + 1
+    for( uint32_t i = 1; i < 128; i++ )
+      if( !composite[ i ] )
+        for( uint32_t j = ( 2 * i + 1 ) * ( 2 * i + 1 ) / 2; j < 32768; j += 2 * i + 1 )
+          composite[ j ] = true;
+
+    uint16_t n = 0;
+    uint32_t last = 0;
+    for( uint32_t i = 1; i < 32768; i++ )
+    {
+      if( composite[ i ] ) continue;
+      if( n ) t.half_gap[ n - 1 ] = i - last;
+      if( n % small_prime_stride == 0 ) t.checkpoint[ n / small_prime_stride ] = 2 * i + 1;
+      last = i;
+      n++;
+    }
+    return t;
+  }
+
+  // constexpr so the compiler has to build the table, rather than quietly
+  // leaving it to a constructor that would copy 7 KB into RAM
+  template <typename Dummy = void>
+  struct SmallPrimes
+  {
+    static constexpr SmallPrimeTable table = make_small_prime_table();
+  };
+
+  // One copy, however many translation units pull it in
+  template <typename Dummy>
+  constexpr SmallPrimeTable SmallPrimes<Dummy>::table PRIMES_PROGMEM;
+
+  template <typename T>
+  struct BasicSmallPrimeTester : OneShot< BasicSmallPrimeTester<T> >
+  {
+    T k_max,
+      k;
+    volatile bool abrt;
+    uint32_t divisions;  // % done on the last m, for the benchmarks
+
+    BasicSmallPrimeTester() { k = 0; k_max = 1; abrt = false; divisions = 0; }
+
+    static const SmallPrimeTable& table() { return SmallPrimes<>::table; }
+
+    static uint8_t half_gap( uint16_t i ) { return primes_read_byte( &table().half_gap[ i ] ); }
+    static uint16_t checkpoint( uint16_t j ) { return primes_read_word( &table().checkpoint[ j ] ); }
+
+    // How many table primes are <= s
+    static uint16_t n_small_primes_upto( T s )
+    {
+      if( s < 3 ) return 0;
+      // Last checkpoint <= s, then walk the gaps from there
+      uint16_t lo = 0, hi = n_small_prime_checkpoints;
+      while( hi - lo > 1 )
+      {
+        uint16_t mid = ( lo + hi ) / 2;
+        if( checkpoint( mid ) <= s ) lo = mid; else hi = mid;
+      }
+      uint16_t i = lo * small_prime_stride;
+      T p = checkpoint( lo );
+      for( ; i + 1 < n_table_odd_primes; i++ )
+      {
+        T next = p + 2 * (T) half_gap( i );
+        if( next > s ) break;
+        p = next;
+      }
+      return i + 1;
+    }
+
+    bool is_prime( T m )
+    {
+      abrt = false;
+
+      k = 1;
+      k_max = 1;
+      divisions = 0;
+
+      if( m < 2 ) return false;
+      if( m == 2 ) return full_bar();
+      if( ( m & 1 ) == 0 ) return false;
+
+      // The table has every odd prime below 2^16
+      const T table_end = 65535;
+      T s = isqrt( m ),
+        n_small = n_small_primes_upto( s ),
+        n_extra = ( s > table_end ) ? ( s - table_end ) / 2 : 0;
+
+      k_max = n_small + n_extra;
+      if( k_max == 0 )
+      {
+        k_max = 1;
+        return full_bar();  // 3, 5, 7: nothing to divide by
+      }
+
+      T d = 3;
+      for( uint16_t i = 0; i < n_small; i++, k++ )
+      {
+        if( abrt )
+        {
+          k = 0; // Same hack as in PrimeTester
+          return false;
+        }
+        divisions++;
+        if( m % d == 0 ) return false;
+        d += 2 * (T) half_gap( i );
+      }
+
+      // Past the table, just odd numbers
+      for( d = table_end + 2; n_extra; n_extra--, d += 2, k++ )
+      {
+        if( abrt )
+        {
+          k = 0;
+          return false;
+        }
+        divisions++;
+        if( m % d == 0 ) return false;
+      }
+
+      return true;
+    }
+
+    bool full_bar()
+    {
+      k = 2;  // (k - 1) / k_max = 1
+      return true;
+    }
+  };
+
+  typedef BasicSmallPrimeTester<prime_t> SmallPrimeTester;
+#endif
+
+
+  // ( a + b ) mod n for a, b < n, without overflowing
+  inline uint64_t addmod( uint64_t a, uint64_t b, uint64_t n )
+  {
+    return ( a >= n - b ) ? a - ( n - b ) : a + b;
+  }
+
+  // ( a * b ) mod n for a, b < n, without overflowing
+  inline uint64_t mulmod( uint64_t a, uint64_t b, uint64_t n )
+  {
+    if( ( n >> 32 ) == 0 ) return a * b % n;  // a * b fits in 64 bits
+#ifdef __SIZEOF_INT128__
+    return (uint64_t) ( (unsigned __int128) a * b % n );
+#else
+    // No 128 bit type (e.g. avr-gcc), so fall back to shift and add
+    uint64_t r = 0;
+    for( ; b; b >>= 1 )
+    {
+      if( b & 1 ) r = addmod( r, a, n );
+      a = addmod( a, a, n );
+    }
+    return r;
+#endif
+  }
+
+  // ( a ^ d ) mod n
+  inline uint64_t powmod( uint64_t a, uint64_t d, uint64_t n )
+  {
+    uint64_t r = 1;
+    a %= n;
+    for( ; d; d >>= 1 )
+    {
+      if( d & 1 ) r = mulmod( r, a, n );
+      a = mulmod( a, a, n );
+    }
+    return r;
+  }
+
+  // Is odd n > 2, with n - 1 = d * 2^s, a strong probable prime to base a?
+  inline bool strong_probable_prime( uint64_t n, uint64_t d, uint8_t s, uint64_t a )
+  {
+    a %= n;
+    if( a == 0 ) return true;  // Witness is a multiple of n, tells us nothing
+    uint64_t x = powmod( a, d, n );
+    if( x == 1 || x == n - 1 ) return true;
+    for( uint8_t r = 1; r < s; r++ )
+    {
+      x = mulmod( x, x, n );
+      if( x == n - 1 ) return true;
+    }
+    return false;
+  }
+
+  /*
+    Deterministic Miller-Rabin. Same interface as PrimeTester, but the
+    cost per number is a handful of modular exponentiations no matter
+    how large m gets.
+
+    The witness sets are the known minimal ones that have been verified
+    to give no false positives:
+      n < 4,759,123,141 (covers all of uint32_t): 2, 7, 61 (Jaeschke)
+      n < 2^64: 2, 325, 9375, 28178, 450775, 9780504, 1795265022 (Sinclair)
+
+    k counts witnesses, so the bar grows by one step per witness and a
+    prime passes all k_max of them. The arithmetic is done in 64 bits, so
+    this is available for prime types up to 64 bits wide.
+  */
+  template <typename T>
+  struct BasicMillerRabinTester : OneShot< BasicMillerRabinTester<T> >
+  {
+    static_assert( sizeof( T ) <= sizeof( uint64_t ), "Miller-Rabin is only proven up to 2^64" );
+
+    T k_max,  // number of witnesses needed for this m
+      k;      // number of witnesses already checked
+    volatile bool abrt;
+
+    BasicMillerRabinTester() { k = 0; k_max = 1; abrt = false; }
+
+    bool is_prime( T m )
+    {
+      static const uint32_t witnesses_32[] = { 2, 7, 61 };
+      static const uint32_t witnesses_64[] = {
+        2, 325, 9375, 28178, 450775, 9780504, 1795265022 };
+
+      abrt = false;
+
+      k = 1;
+      k_max = 1;
+
+      if( m < 2 ) return false;
+      if( m == 2 || m == 3 ) return true;
+      if( m % 2 == 0 ) return false;
+      if( m % 3 == 0 ) return false;
+
+      uint64_t d = (uint64_t) m - 1;
+      uint8_t s = 0;
+      while( d % 2 == 0 ) { d /= 2; s++; }
+
+      const uint32_t *witness = witnesses_32;
+      k_max = 3;
+      if( (uint64_t) m >= 4759123141ULL )
+      {
+        witness = witnesses_64;
+        k_max = 7;
+      }
+
+      for( k = 1; k <= k_max; k++ )
+      {
+        if( abrt )
+        {
+          k = 0; // Same hack as in PrimeTester
+          return false;
+        }
+        if( !strong_probable_prime( m, d, s, witness[ k - 1 ] ) ) return false;
+      }
+
       return true;
     }
   };
 
-  struct PrimeClock
+  typedef BasicMillerRabinTester<prime_t> MillerRabinTester;
+
+
+  // Size of the sieve window in bytes. One bit per odd number, so the default
+  // covers half a million numbers and fits in a typical L1 data cache
+  const uint32_t sieve_window_bytes = 32 * 1024;
+
+  /*
+    A segmented Sieve of Eratosthenes with the same interface as PrimeTester.
+
+    This is meant for the host build, where we scan long stretches of numbers
+    sequentially. When asked about an m outside the current window we sieve a
+    fresh window starting at m, so sequential calls cost a bit lookup and
+    random jumps cost one window. It needs the primes up to sqrt(m) plus the
+    window in RAM, so this is NOT something to use on the Uno.
+
+    There are no divisors being tested one by one here, so k/k_max only
+    report the verdict: a full bar for primes and an empty bar for composites.
+  */
+  template <typename T>
+  struct BasicSieveTester : OneShot< BasicSieveTester<T> >
+  {
+    T k_max,
+      k;
+    volatile bool abrt;  // Unused, kept so we can stand in for PrimeTester
+
+    uint8_t *window;     // bit i set => lo + 2i is composite
+    T lo, hi;            // window covers the odd numbers in [lo, hi]
+    bool window_valid;
+
+    T *base;             // primes 3, 5, 7 ... up to base_limit
+    uint32_t n_base, base_size;
+    T base_limit;
+
+    BasicSieveTester()
+    {
+      k = 0; k_max = 1; abrt = false;
+      window = new uint8_t[ sieve_window_bytes ];
+      window_valid = false;
+      base = 0; n_base = 0; base_size = 0; base_limit = 2;
+    }
+
+    ~BasicSieveTester() { delete[] window; delete[] base; }
+
+    BasicSieveTester( const BasicSieveTester& ) = delete;
+    BasicSieveTester& operator=( const BasicSieveTester& ) = delete;
+
+    bool is_prime( T m )
+    {
+      k = 1;
+      k_max = 1;
+
+      if( m < 2 ) return false;
+      if( m == 2 ) return full_bar_if( true );
+      if( m % 2 == 0 ) return false;
+
+      if( !window_valid || m < lo || m > hi ) sieve_window( m );
+      T i = ( m - lo ) / 2;
+      return full_bar_if( ( window[ i / 8 ] & ( 1 << ( i % 8 ) ) ) == 0 );
+    }
+
+    bool full_bar_if( bool p )
+    {
+      if( p ) k = 2;  // (k - 1) / k_max = 1 => full bar
+      return p;
+    }
+
+    // Sieve the odd numbers in [_lo, _lo + 16 * sieve_window_bytes), or up to
+    // the largest T, whichever comes first
+    void sieve_window( T _lo )
+    {
+      lo = _lo | 1;
+      const T span = 2 * ( 8 * (T) sieve_window_bytes - 1 );
+      hi = ( (T) -1 - lo < span ) ? (T) -1 : lo + span;
+
+      while( base_limit <= hi / base_limit ) extend_base_primes( 2 * base_limit );
+      memset( window, 0, sieve_window_bytes );
+
+      const T n_bits = ( hi - lo ) / 2 + 1;
+      for( uint32_t b = 0; b < n_base; b++ )
+      {
+        T p = base[ b ];
+        if( p > hi / p ) break;  // p * p > hi
+
+        // Offset from lo to the first odd multiple of p that is in the window
+        // and is >= p * p. Working with offsets keeps us clear of overflow
+        // at the top of the range
+        T r;
+        if( p * p >= lo ) r = p * p - lo;
+        else
+        {
+          r = ( p - lo % p ) % p;
+          if( r % 2 == 1 ) r += p;  // lo is odd, so lo + r must be too
+        }
+        for( T i = r / 2; i < n_bits; i += p )
+          window[ i / 8 ] |= 1 << ( i % 8 );
+      }
+      window_valid = true;
+    }
+
+    // Regenerate the odd primes up to `limit`. A plain sieve is fine here:
+    // limit never goes much beyond sqrt of the largest T
+    void extend_base_primes( T limit )
+    {
+      uint8_t *composite = new uint8_t[ limit + 1 ];
+      memset( composite, 0, limit + 1 );
+      n_base = 0;
+      for( T i = 3; i <= limit; i += 2 )
+      {
+        if( composite[ i ] ) continue;
+        if( n_base == base_size )
+        {
+          base_size = base_size ? 2 * base_size : 1024;
+          T *_base = new T[ base_size ];
+          if( n_base ) memcpy( _base, base, n_base * sizeof( T ) );  // base is null the first time
+          delete[] base;
+          base = _base;
+        }
+        base[ n_base++ ] = i;
+        if( i > limit / i ) continue;
+        for( T j = i * i; j <= limit; j += 2 * i ) composite[ j ] = 1;
+      }
+      delete[] composite;
+      base_limit = limit;
+    }
+  };
+
+  typedef BasicSieveTester<prime_t> SieveTester;
+
+
+  // convert last digit of prime {1, 3, 7, 9} to index into rloks table {0, 1, 2, 3}
+  template <typename T>
+  inline uint8_t last_digit_index( T n )
+  {
+    switch( n % 10 )
+    {
+      case 1: return 0;
+      case 3: return 1;
+      case 7: return 2;
+      case 9: return 3;
+      default: return 0;  // Testing should catch this
+    }
+  }
+
+#ifndef __AVR__
+  /*
+    pi(x), the number of primes <= x, without testing them all.
+
+    Lucy_Hedgehog's method: S(v) starts as the count of 2..v and we sieve
+    out the multiples of each prime p <= sqrt(x) with
+      S(v) -= S(v / p) - S(p - 1)   for v >= p * p
+    Only the values v = x / i are ever needed, and there are about
+    2 sqrt(x) of those, so this is O(x^3/4) time and O(sqrt(x)) space.
+    2^32 takes a few hundredths of a second and 1 MB, which is why this is
+    host only.
+  */
+  template <typename T>
+  T prime_pi( T x )
+  {
+    if( x < 2 ) return 0;
+    const T r = isqrt( x );
+    T *lo = new T[ r + 1 ],  // lo[ v ] = S( v )
+      *hi = new T[ r + 1 ];  // hi[ i ] = S( x / i )
+    for( T i = 1; i <= r; i++ )
+    {
+      lo[ i ] = i - 1;
+      hi[ i ] = x / i - 1;
+    }
+
+    for( T p = 2; p <= r; p++ )
+    {
+      if( lo[ p ] == lo[ p - 1 ] ) continue;  // p is not prime
+      const T c = lo[ p - 1 ],  // primes below p
+              p2 = p * p,
+              i_end = x / p2 < r ? x / p2 : r;
+      for( T i = 1; i <= i_end; i++ )
+      {
+        const T d = i * p;
+        hi[ i ] -= ( d <= r ? hi[ d ] : lo[ x / d ] ) - c;
+      }
+      for( T v = r; v >= p2; v-- )
+        lo[ v ] -= lo[ v / p ] - c;
+    }
+
+    T pi = hi[ 1 ];
+    delete[] lo;
+    delete[] hi;
+    return pi;
+  }
+
+  // Above this, restart_clock_from() doesn't work out pi(m): it would
+  // take seconds to hours and up to GBs for the wide clocks
+  const uint64_t exact_restart_limit = 1ULL << 32;
+#endif
+
+  // Largest prime <= m, 1 if there isn't one
+  template <typename T>
+  T prime_at_or_below( T m )
+  {
+    BasicPrimeTester<T> pt;
+    for( ; m >= 2; m-- )
+      if( pt.is_prime( m ) ) return m;
+    return 1;
+  }
+
+  /*
+    The clock's metrics for a stretch of numbers [lo, hi], in a form that
+    can be combined with the metrics of the stretch right after it. This
+    lets us compute pieces of the number line separately (other threads,
+    other machines, earlier runs) and reduce them cheaply.
+
+    a.merge( b ) is associative and the default constructed (empty) stats
+    is its identity. b has to start right after a ends: the first and last
+    primes are kept so that the twin and last digit transition at the
+    seam can be counted.
+  */
+  template <typename T>
+  struct BasicPrimeStats
+  {
+    T lo, hi,         // numbers covered. hi < lo => empty
+      first_prime,    // 0 => no primes in [lo, hi]
+      last_prime,
+      primes_found,
+      twin_primes_found,
+      palindromic_primes_found,
+      rloks[ 4 ][ 4 ];
+    bool last_is_twin;  // last_prime - 2 is also a prime
+
+    BasicPrimeStats() { clear( 1, 0 ); }
+    BasicPrimeStats( T _lo, T _hi ) { clear( _lo, _hi ); }
+
+    void clear( T _lo, T _hi )
+    {
+      lo = _lo;
+      hi = _hi;
+      first_prime = 0;
+      last_prime = 0;
+      primes_found = 0;
+      twin_primes_found = 0;
+      palindromic_primes_found = 0;
+      for( int i = 0; i < 4; i++ )
+        for( int j = 0; j < 4; j++ )
+          rloks[ i ][ j ] = 0;
+      last_is_twin = false;
+    }
+
+    bool empty() const { return hi < lo; }
+
+    // Primes have to be added in increasing order
+    void add_prime( T p )
+    {
+      if( primes_found )
+      {
+        if( p > 7 ) rloks[ last_digit_index( last_prime ) ][ last_digit_index( p ) ]++;
+        last_is_twin = p - last_prime == 2;
+        if( last_is_twin ) twin_primes_found++;
+      }
+      else
+        first_prime = p;
+      primes_found++;
+      if( is_palindrome( p ) ) palindromic_primes_found++;
+      last_prime = p;
+    }
+
+    // *this becomes *this followed by b
+    void merge( const BasicPrimeStats& b )
+    {
+      if( b.empty() ) return;
+      if( empty() ) { *this = b; return; }
+
+      if( b.primes_found )
+      {
+        if( primes_found )
+        {
+          bool seam_twin = b.first_prime - last_prime == 2;
+          if( b.first_prime > 7 )
+            rloks[ last_digit_index( last_prime ) ][ last_digit_index( b.first_prime ) ]++;
+          if( seam_twin ) twin_primes_found++;
+          last_is_twin = b.primes_found > 1 ? b.last_is_twin : seam_twin;
+        }
+        else
+        {
+          first_prime = b.first_prime;
+          last_is_twin = b.last_is_twin;
+        }
+        last_prime = b.last_prime;
+        primes_found += b.primes_found;
+        twin_primes_found += b.twin_primes_found;
+        palindromic_primes_found += b.palindromic_primes_found;
+        for( int i = 0; i < 4; i++ )
+          for( int j = 0; j < 4; j++ )
+            rloks[ i ][ j ] += b.rloks[ i ][ j ];
+      }
+      hi = b.hi;
+    }
+  };
+
+  typedef BasicPrimeStats<prime_t> PrimeStats;
+
+
+  // Bits in BasicCheckBlock::flags
+  const uint8_t flag_prime = 1,
+                flag_twin_prime = 2,
+                flag_palindromic_prime = 4;
+
+  /*
+    The results of BasicPrimeClock::check_range() for up to N numbers, one
+    array per field so a consumer can run down just the ones it needs.
+  */
+  template <typename T, uint16_t N>
+  struct BasicCheckBlock
+  {
+    uint16_t n;         // entries filled in
+    T m[ N ];
+    uint8_t flags[ N ]; // flag_prime | flag_twin_prime | flag_palindromic_prime
+    uint32_t f16[ N ];  // fraction_tested_q16() when m[ i ] was done, ready for the chart
+  };
+
+  typedef BasicCheckBlock<prime_t, 16> CheckBlock;
+
+
+  // Fractions in Q16 fixed point, for the display: q16_one is all of it
+  const uint32_t q16_one = 1UL << 16;
+
+  // floor( num * 2^16 / den ), clamped to q16_one. Long division one bit
+  // at a time, so there are no wide multiplies and nothing can overflow
+  template <typename T>
+  uint32_t q16_ratio( T num, T den )
+  {
+    if( num >= den ) return q16_one;
+    uint32_t q = 0;
+    for( uint8_t i = 0; i < 16; i++ )
+    {
+      q <<= 1;
+      // num < den, so compare 2 num with den without forming 2 num
+      if( num >= den - num ) { num -= den - num; q |= 1; }
+      else num <<= 1;
+    }
+    return q;
+  }
+
+  /*
+    Everything the clock knows after stepping through 1 .. m. The table of
+    these for the touch screen start points is made on the host by
+    host/snapshot_gen.cpp (see clock_snapshots.h) so a jump to one of them
+    keeps the full stats. T is the clock's integer type.
+  */
+  template <typename T>
+  struct BasicClockSnapshot
+  {
+    T m,
+      last_prime,
+      primes_found,
+      twin_primes_found,
+      palindromic_primes_found,
+      rloks[ 4 ][ 4 ];
+  };
+
+  typedef BasicClockSnapshot<prime_t> ClockSnapshot;
+
+  // How far the clock has got with the number it is on
+  template <typename T>
+  struct BasicClockProgress
+  {
+    T m, k, k_max;  // As in the clock and its tester
+
+    // As BasicPrimeClock::fraction_tested_q16()
+    uint32_t fraction_tested_q16() const
+    {
+      if( k == 0 ) return 0;
+      return q16_ratio( (T) ( k - 1 ), k_max );
+    }
+  };
+
+  typedef BasicClockProgress<prime_t> ClockProgress;
+
+  /*
+    A seqlock: one writer publishes a D, any number of readers take copies,
+    and nobody takes a lock. seq is odd while a write is under way. A
+    reader that sees it odd, or sees it move while copying, has a torn copy
+    and tries again. The writer never waits.
+
+    The copies are done a byte at a time with atomic loads and stores, so
+    this isn't a data race on the host, and a byte is all the Uno can load
+    in one go anyway (which is why seq is a byte there).
+
+    A reader that can interrupt the writer (an ISR on the Uno) must use
+    try_read() and keep its last copy when it fails. The writer can't
+    finish while the ISR spins.
+  */
+#ifdef __AVR__
+  typedef uint8_t seq_t;
+#else
+  typedef uint32_t seq_t;
+#endif
+
+  template <typename D>
+  struct SeqLock
+  {
+    D data;
+    seq_t seq;
+
+    SeqLock() : seq( 0 ) {}
+
+    void publish( const D& d )
+    {
+      seq_t s = __atomic_load_n( &seq, __ATOMIC_RELAXED );
+      __atomic_store_n( &seq, (seq_t) ( s + 1 ), __ATOMIC_RELAXED );
+      __atomic_thread_fence( __ATOMIC_RELEASE );  // odd seq goes out before the data
+      const uint8_t *src = (const uint8_t*) &d;
+      uint8_t *dst = (uint8_t*) &data;
+      for( size_t i = 0; i < sizeof( D ); i++ )
+        __atomic_store_n( dst + i, src[ i ], __ATOMIC_RELAXED );
+      __atomic_store_n( &seq, (seq_t) ( s + 2 ), __ATOMIC_RELEASE );
+    }
+
+    // False if the copy is torn, d is garbage then
+    bool try_read( D& d ) const
+    {
+      seq_t s = __atomic_load_n( &seq, __ATOMIC_ACQUIRE );
+      if( s & 1 ) return false;
+      const uint8_t *src = (const uint8_t*) &data;
+      uint8_t *dst = (uint8_t*) &d;
+      for( size_t i = 0; i < sizeof( D ); i++ )
+        dst[ i ] = __atomic_load_n( src + i, __ATOMIC_RELAXED );
+      __atomic_thread_fence( __ATOMIC_ACQUIRE );  // the data is in before we look again
+      return __atomic_load_n( &seq, __ATOMIC_RELAXED ) == s;
+    }
+
+    void read( D& d ) const { while( !try_read( d ) ); }
+
+    // Goes up by two with each publish
+    seq_t version() const { return __atomic_load_n( &seq, __ATOMIC_ACQUIRE ); }
+  };
+
+  /*
+    The clock steps through the numbers one by one and keeps the metrics.
+    Which primality test it uses is up to the Tester: PrimeTester (trial
+    division) is what runs on the device. WheelTester is the same idea with
+    fewer wasted divisions, and ResidueTester does it with no divisions at
+    all as long as the clock only steps by one. SmallPrimeTester divides
+    by primes only (needs C++14). MillerRabinTester keeps the cost per
+    number nearly flat as m grows. On the host you may want SieveTester for bulk
+    sequential scanning. PrefilterTester (prefilter.h) can be put in front
+    of any of them.
+  */
+  template <typename T, typename Tester = BasicPrimeTester<T> >
+  struct BasicPrimeClock
   {
-    prime_t m,            // current number being tested,
-            last_prime,   // most recent prime found
-            primes_found, 
-            twin_primes_found,
-            palindromic_primes_found,
-            // (1, 3, 7, 9) x (1, 3, 7, 9) grid
-            // see https://www.scientificamerican.com/article/peculiar-pattern-found-in-random-prime-numbers/                  
-            rloks[ 4 ][ 4 ]; // can't use floats/doubles because of precision issues
+    T m,            // current number being tested,
+      last_prime,   // most recent prime found
+      primes_found, 
+      twin_primes_found,
+      palindromic_primes_found,
+      // (1, 3, 7, 9) x (1, 3, 7, 9) grid
+      // see https://www.scientificamerican.com/article/peculiar-pattern-found-in-random-prime-numbers/                  
+      rloks[ 4 ][ 4 ]; // can't use floats/doubles because of precision issues
 
-    PrimeTester pt;
-    char m_string[ p_max_d + 1 ];  // m as a string
+    Tester pt;
+    char m_string[ PrimeTraits<T>::max_digits + 1 ];  // m as a string
     char *m_ptr;  // pointer into m_string
     bool is_prime, is_twin_prime, is_palindromic_prime;
 
-    void restart_clock_from( prime_t _m )
+    // If set, the clock publishes to these as it goes, for readers on
+    // other threads (or ISRs). Progress goes out after every slice and
+    // number, stats after every number
+    SeqLock< BasicClockProgress<T> > *progress_out;
+    SeqLock< BasicClockSnapshot<T> > *stats_out;
+
+    void restart_clock_from( T _m )
     {
       pt.abrt = true;
       m = _m;
+      // Not enough RAM (on the Uno) or time (far out) for pi(m), so as a
+      // rule the counts start again from here
       last_prime = 1;
       primes_found = 0;
+#ifndef __AVR__
+      // But where it is cheap, the true count, so the stats don't restart
+      // from zero after a jump
+      if( sizeof( T ) <= sizeof( uint32_t ) || _m <= (T) exact_restart_limit )
+      {
+        primes_found = prime_pi( _m );
+        last_prime = prime_at_or_below( _m );
+      }
+#endif
       twin_primes_found = 0;
       palindromic_primes_found = 0;
       for( int i = 0; i < 4; i++ )
         for( int j = 0; j < 4; j++ )
           rloks[ i ][ j ] = 0;
+      publish();
+    }
+
+    // Pick up from a snapshot, as if we had stepped all the way to s.m
+    void restore( const BasicClockSnapshot<T>& s )
+    {
+      pt.abrt = true;
+      m = s.m;
+      last_prime = s.last_prime;
+      primes_found = s.primes_found;
+      twin_primes_found = s.twin_primes_found;
+      palindromic_primes_found = s.palindromic_primes_found;
+      for( int i = 0; i < 4; i++ )
+        for( int j = 0; j < 4; j++ )
+          rloks[ i ][ j ] = s.rloks[ i ][ j ];
+      publish();
+    }
+
+    // The other way round: what restore() needs to get back to here
+    void snapshot( BasicClockSnapshot<T>& s ) const
+    {
+      s.m = m;
+      s.last_prime = last_prime;
+      s.primes_found = primes_found;
+      s.twin_primes_found = twin_primes_found;
+      s.palindromic_primes_found = palindromic_primes_found;
+      for( int i = 0; i < 4; i++ )
+        for( int j = 0; j < 4; j++ )
+          s.rloks[ i ][ j ] = rloks[ i ][ j ];
     }
 
-    PrimeClock()
+    BasicPrimeClock()
     {
-      m_string[ p_max_d ] = '\0';      
+      progress_out = nullptr;
+      stats_out = nullptr;
+      m_string[ PrimeTraits<T>::max_digits ] = '\0';      
       restart_clock_from( 1 );
     }
 
@@ -168,24 +1383,42 @@ namespace primes {
       // m_ptr now points to start of the converted number
     }
 
-    // convert last digit of prime {1, 3, 7, 9} to index into rloks table {0, 1, 2, 3}
-    uint8_t ldi( prime_t n )
+    static uint8_t ldi( T n ) { return last_digit_index( n ); }
+
+    // Increment the clock, test if this next number is prime and update metrics
+    void check_next()
     {
-      switch( n % 10 )
+      m++;
+      update_metrics( pt.is_prime( m ) );
+    }
+
+    /*
+      check_next() in slices, for testers that can be resumed (PrimeTester).
+      start_next() moves on to m + 1, then each resume_next( budget ) does
+      up to budget steps of the test. It returns true once m is done and the
+      metrics are updated, just as check_next() would have left them.
+    */
+    void start_next()
+    {
+      m++;
+      pt.start( m );
+    }
+
+    bool resume_next( T budget )
+    {
+      if( !pt.resume( budget ) )
       {
-        case 1: return 0;
-        case 3: return 1;
-        case 7: return 2;
-        case 9: return 3;
-        default: return 0;  // Testing should catch this
+        publish_progress();
+        return false;
       }
+      if( pt.k == 0 ) is_prime = false;  // aborted, e.g. by restart_clock_from()
+      else update_metrics( pt.verdict );
+      return true;
     }
 
-    // Increment the clock, test if this next number is prime and update metrics
-    void check_next()
+    void update_metrics( bool m_is_prime )
     {
-      m++;
-      if( pt.is_prime( m ) )
+      if( m_is_prime )
       {
         is_prime = true;
         primes_found++;
@@ -205,7 +1438,7 @@ namespace primes {
 
         set_string_representation();        
         // Test palindrome
-        if( is_palindrome( m_ptr ) )
+        if( is_palindrome( (const char*) m_ptr ) )
         {
           palindromic_primes_found++;
           is_palindromic_prime = true;          
@@ -216,6 +1449,106 @@ namespace primes {
       }
       else
         is_prime = false;  // The other flags don't matter then
+      publish();
+    }
+
+    void publish_progress()
+    {
+      if( !progress_out ) return;
+      BasicClockProgress<T> p;
+      p.m = m;
+      p.k = pt.k;
+      p.k_max = pt.k_max;
+      progress_out->publish( p );
+    }
+
+    void publish()
+    {
+      publish_progress();
+      if( !stats_out ) return;
+      BasicClockSnapshot<T> s;
+      snapshot( s );
+      stats_out->publish( s );
+    }
+
+    /*
+      Fold in the metrics for the numbers right after m, as if we had
+      stepped through them with check_next(). s.lo should be m + 1.
+      The tester is not touched, so k/k_max still refer to the last number
+      we tested ourselves.
+    */
+    void absorb( const BasicPrimeStats<T>& s )
+    {
+      if( s.empty() ) return;
+      m = s.hi;
+      if( s.primes_found )
+      {
+        if( s.first_prime > 7 ) rloks[ ldi( last_prime ) ][ ldi( s.first_prime ) ]++;
+        bool seam_twin = s.first_prime - last_prime == 2;
+        if( seam_twin ) twin_primes_found++;
+        is_twin_prime = s.primes_found > 1 ? s.last_is_twin : seam_twin;
+
+        primes_found += s.primes_found;
+        twin_primes_found += s.twin_primes_found;
+        palindromic_primes_found += s.palindromic_primes_found;
+        for( int i = 0; i < 4; i++ )
+          for( int j = 0; j < 4; j++ )
+            rloks[ i ][ j ] += s.rloks[ i ][ j ];
+        last_prime = s.last_prime;
+      }
+
+      is_prime = last_prime == m;
+      if( is_prime )
+      {
+        set_string_representation();
+        is_palindromic_prime = is_palindrome( (const char*) m_ptr );
+      }
+      publish();
+    }
+
+    /*
+      check_next() n times over (at most N), with the results going into b
+      instead of the scalar flags. Afterwards the flags and the string are
+      as check_next() would have left them. Returns how many were done.
+    */
+    template <uint16_t N>
+    uint16_t check_range( BasicCheckBlock<T, N>& b, uint16_t n )
+    {
+      if( n > N ) n = N;
+      uint8_t f = 0;
+      for( uint16_t i = 0; i < n; i++ )
+      {
+        const T c = ++m;
+        f = 0;
+        if( pt.is_prime( c ) )
+        {
+          f = flag_prime;
+          primes_found++;
+          if( c > 7 ) rloks[ ldi( last_prime ) ][ ldi( c ) ]++;
+          if( c - last_prime == 2 )
+          {
+            twin_primes_found++;
+            f |= flag_twin_prime;
+          }
+          if( is_palindrome( c ) )
+          {
+            palindromic_primes_found++;
+            f |= flag_palindromic_prime;
+          }
+          last_prime = c;
+        }
+        b.m[ i ] = c;
+        b.flags[ i ] = f;
+        b.f16[ i ] = fraction_tested_q16();
+      }
+      b.n = n;
+
+      is_prime = f & flag_prime;
+      is_twin_prime = f & flag_twin_prime;
+      is_palindromic_prime = f & flag_palindromic_prime;
+      if( last_prime > 1 ) m_ptr = prime_t_to_str( last_prime, m_string );
+      publish();  // Once a block, not every number
+      return n;
     }
 
     // What fraction of the divisors have been tested?
@@ -224,12 +1557,28 @@ namespace primes {
       return ((float) pt.k - 1) / (float) pt.k_max;
     }
 
+    // The same in Q16, clamped to [0, q16_one], with no float. This is
+    // what the display uses, so the partial redraw stays cheap
+    uint32_t fraction_tested_q16() const
+    {
+      if( pt.k == 0 ) return 0;  // aborted
+      return q16_ratio( (T) ( pt.k - 1 ), pt.k_max );
+    }
+
     const char *m_as_string() const
     {
       return (const char*) m_ptr;
     }
   };
 
+  // Pick the primality test the clock runs with. As with prime_t, uncomment
+  // the one you want
+  typedef BasicPrimeClock<prime_t> PrimeClock;  // trial division
+  // typedef BasicPrimeClock<prime_t, WheelTester> PrimeClock;  // trial division, mod 210 wheel
+  // typedef BasicPrimeClock<prime_t, ResidueTester> PrimeClock;  // incremental residues, no division
+  // typedef BasicPrimeClock<prime_t, SmallPrimeTester> PrimeClock;  // trial division by primes, table in flash
+  // typedef BasicPrimeClock<prime_t, MillerRabinTester> PrimeClock;  // deterministic Miller-Rabin
+
 }
 
 #endif // _PRIMES_H_
@@ -11,11 +11,13 @@
 
 #include "tftconstants.h"
 #include "primes.h"
+#include "debounce.h"
 
 
 namespace touchscreen 
 {
   using namespace primes;
+  using namespace debounce;
   
   TouchScreen ts = TouchScreen( XP, YP, XM, YM, TS_OHMS );
 
@@ -30,6 +32,15 @@ namespace touchscreen
     return (uint32_t)1 << pow;
   }
 
+  // Just the pressure, two analog reads rather than getPoint()'s dozen or so
+  uint16_t get_pressure()
+  {
+    uint16_t z = ts.pressure();
+    pinMode(XM, OUTPUT);
+    pinMode(YP, OUTPUT);
+    return z;
+  }
+
   TSPoint get_touch_point()
   {
     digitalWrite(13, HIGH);
@@ -59,6 +70,9 @@ namespace touchscreen
     prime_t new_m;
     int screen_height, screen_width;
 
+    TouchDebouncer debouncer;
+    EventQueue<TouchEvent, 4> taps;
+
     void init( Elegoo_TFTLCD *tft )
     {
       pinMode(13, OUTPUT);
@@ -70,6 +84,7 @@ namespace touchscreen
     // from a value of m that is mapped to the co-ordinates
     void interpret_touch( TSPoint p )
     {
+      cmd_type = TouchCommandType::Nothing;
       if( ( p.y < 140 ) )
       {
         cmd_type = TouchCommandType::Switch;      
@@ -78,26 +93,28 @@ namespace touchscreen
       {
         cmd_type = TouchCommandType::Set;
         new_m = point_to_prime( p );
-        delay( 250 );  // Give us time to remove the stylus
       }
     }
-  
+
+    // Reads the screen and moves the debouncer along. Never waits, and
+    // when nobody is touching it is a single pressure reading
+    void sample( unsigned long now )
+    {
+      TSPoint p( 0, 0, 0 );
+      uint16_t z = get_pressure();
+      if( z > MINPRESSURE && z < MAXPRESSURE ) p = get_touch_point();
+      if( debouncer.update( p, now ) ) taps.push( debouncer.event );
+    }
+
+    // The next tap as a command, in cmd_type (and new_m). False when there
+    // are no more taps
     bool poll()
     {
-      cmd_type = TouchCommandType::Nothing;      
-      TSPoint p = get_touch_point();
-      // we have some minimum pressure we consider 'valid'
-      // pressure of 0 means no pressing!
-      if (p.z > MINPRESSURE && p.z < MAXPRESSURE) 
-      {
-        interpret_touch( p );
-        return true;
-      }
-      else
-      {
-        cmd_type = TouchCommandType::Nothing;
-        return false;
-      }
+      TouchEvent e;
+      cmd_type = TouchCommandType::Nothing;
+      if( !taps.pop( e ) ) return false;
+      interpret_touch( e.p );
+      return true;
     }
   };
 }
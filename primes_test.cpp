@@ -1,11 +1,19 @@
 // Yes we have tests
 // We ARE professional
 
-// g++ primes_test.cpp -o pt
+// g++ -std=c++14 -pthread primes_test.cpp -o pt
 
 #include <iostream>
 #include <cassert>
+#include <cstring>
+#include <atomic>
 #include "moulick/primes.h"
+#include "moulick/prefilter.h"
+#include "moulick/clock_snapshots.h"
+#include "moulick/checkpoint.h"
+#include "host/scanner.h"
+#include "host/prime_archive.h"
+#include "host/pipeline.h"
 
 using namespace primes;
 
@@ -142,10 +150,1061 @@ void test_large_primes()
     std::cout << "Large primes test passed" << std::endl;
 }
 
+void test_sieve()
+{
+    // The sieve backed clock should agree with the trial division clock
+    // number for number, including across window boundaries
+    PrimeClock pc;
+    BasicPrimeClock<prime_t, SieveTester> sc;
+    for( uint32_t i = 0; i < 16 * sieve_window_bytes + 1000; i++ )
+    {
+        pc.check_next();
+        sc.check_next();
+        assert( pc.is_prime == sc.is_prime );
+        if( pc.is_prime )
+        {
+            assert( pc.is_twin_prime == sc.is_twin_prime );
+            assert( pc.is_palindromic_prime == sc.is_palindromic_prime );
+            assert( sc.fraction_tested() == 1.0 );
+        }
+    }
+    assert( pc.primes_found == sc.primes_found );
+    assert( pc.twin_primes_found == sc.twin_primes_found );
+    assert( pc.palindromic_primes_found == sc.palindromic_primes_found );
+    for( int i = 0; i < 4; i++ )
+        for( int j = 0; j < 4; j++ )
+            assert( pc.rloks[ i ][ j ] == sc.rloks[ i ][ j ] );
+
+    // Random jumps, including right up against the top of prime_t
+    SieveTester st;
+    PrimeTester pt;
+    prime_t starts[] = { 2, 1000000007, (1UL << 31) - 100, 4294967295UL - 1000 };
+    for( int s = 0; s < 4; s++ )
+        for( prime_t m = starts[ s ]; m - starts[ s ] < 1000; m++ )
+            assert( st.is_prime( m ) == pt.is_prime( m ) );
+    assert( st.is_prime( 4294967291UL ) );  // Largest 32 bit prime
+    assert( !st.is_prime( 4294967295UL ) );
+
+    std::cout << "Sieve test passed" << std::endl;
+}
+
+void test_miller_rabin()
+{
+    PrimeTester pt;
+    MillerRabinTester mr;
+    for( prime_t m = 2; m < 100000; m++ )
+        assert( mr.is_prime( m ) == pt.is_prime( m ) );
+
+    uint32_t large_prime[] = { 15485863, 86028121, 472882027, 715225739, 982451653, 4294967291UL };
+    for( int i = 0; i < 6; i++ )
+    {
+        assert( mr.is_prime( large_prime[ i ] ) );
+        assert( mr.k == mr.k_max + 1 );  // A prime passes every witness
+    }
+
+    PrimeClock pc;
+    BasicPrimeClock<prime_t, MillerRabinTester> mc;
+    for( int i = 0; i < 100000; i++ ) { pc.check_next(); mc.check_next(); }
+    assert( pc.primes_found == mc.primes_found );
+    assert( pc.twin_primes_found == mc.twin_primes_found );
+    assert( pc.palindromic_primes_found == mc.palindromic_primes_found );
+
+    // Strong pseudoprimes that fool some, but not all, of the witnesses
+    uint32_t spsp[] = { 2047 /* base 2 */, 3215031751UL /* bases 2, 3, 5, 7 */, 
+                        1373653 /* bases 2, 3 */, 25326001 /* bases 2, 3, 5 */ };
+    for( int i = 0; i < 4; i++ )
+        assert( mr.is_prime( spsp[ i ] ) == false );
+
+    // 64 bit arithmetic, checked directly against the witness loop
+    uint64_t n = 4759123141ULL;  // 48781 * 97561, passes 2, 7 and 61
+    uint64_t d = n - 1; uint8_t s = 0;
+    while( d % 2 == 0 ) { d /= 2; s++; }
+    assert( strong_probable_prime( n, d, s, 2 ) );
+    assert( strong_probable_prime( n, d, s, 7 ) );
+    assert( strong_probable_prime( n, d, s, 61 ) );
+    uint64_t witnesses[] = { 2, 325, 9375, 28178, 450775, 9780504, 1795265022 };
+    bool caught = false;
+    for( int i = 0; i < 7; i++ )
+        caught |= !strong_probable_prime( n, d, s, witnesses[ i ] );
+    assert( caught );
+
+    n = 18446744073709551557ULL;  // Largest 64 bit prime
+    d = n - 1; s = 0;
+    while( d % 2 == 0 ) { d /= 2; s++; }
+    for( int i = 0; i < 7; i++ )
+        assert( strong_probable_prime( n, d, s, witnesses[ i ] ) );
+
+    std::cout << "Miller-Rabin test passed" << std::endl;
+}
+
+void test_widths()
+{
+    assert( PrimeTraits<uint32_t>::max_digits == 10 );
+    assert( PrimeTraits<uint64_t>::max_digits == 20 );
+    assert( PrimeTraits<uint128_t>::max_digits == 39 );
+
+    // Square roots have to be exact right up to the top of each width
+    assert( isqrt( (uint32_t) 4294967295UL ) == 65535 );
+    assert( isqrt( (uint32_t) 4294836225UL ) == 65535 );  // 65535^2
+    assert( isqrt( (uint32_t) 4294836224UL ) == 65534 );
+    assert( isqrt( (uint64_t) 18446744073709551615ULL ) == 4294967295ULL );
+    assert( isqrt( (uint64_t) 18446744065119617025ULL ) == 4294967295ULL );  // (2^32 - 1)^2
+    assert( isqrt( (uint64_t) 18446744065119617024ULL ) == 4294967294ULL );
+    assert( isqrt( (uint128_t) ~(uint128_t) 0 ) == 18446744073709551615ULL );
+    for( uint32_t m = 0; m < 100000; m++ )
+    {
+        uint32_t r = isqrt( m );
+        assert( r * r <= m && ( r + 1 ) * ( r + 1 ) > m );
+    }
+
+    char buf[ PrimeTraits<uint128_t>::max_digits + 1 ];
+    buf[ PrimeTraits<uint128_t>::max_digits ] = '\0';
+    assert( strcmp( prime_t_to_str( ~(uint128_t) 0, buf ), "340282366920938463463374607431768211455" ) == 0 );
+    char buf64[ PrimeTraits<uint64_t>::max_digits + 1 ];
+    buf64[ PrimeTraits<uint64_t>::max_digits ] = '\0';
+    assert( strcmp( prime_t_to_str( (uint64_t) 18446744073709551557ULL, buf64 ), "18446744073709551557" ) == 0 );
+
+    assert( is_palindrome( (uint32_t) 12321 ) );
+    assert( !is_palindrome( (uint32_t) 12331 ) );
+    assert( is_palindrome( (uint64_t) 10000000000000000001ULL ) );
+    assert( is_palindrome( (uint128_t) 10000000000000000001ULL * 10000000000ULL + 10000000000ULL ) == false );
+
+    // All three widths side by side should agree on the same range
+    BasicPrimeClock<uint32_t> c32;
+    BasicPrimeClock<uint64_t> c64;
+    BasicPrimeClock<uint128_t> c128;
+    for( int i = 0; i < 100000; i++ )
+    {
+        c32.check_next(); c64.check_next(); c128.check_next();
+        assert( c32.is_prime == c64.is_prime && c32.is_prime == c128.is_prime );
+        assert( strcmp( c32.m_as_string(), c128.m_as_string() ) == 0 || !c32.is_prime );
+    }
+    assert( c32.primes_found == c64.primes_found && c32.primes_found == c128.primes_found );
+    assert( c32.palindromic_primes_found == c128.palindromic_primes_found );
+
+    // Past four billion
+    BasicPrimeTester<uint64_t> pt64;
+    assert( pt64.is_prime( 4294967311ULL ) );  // First prime above 2^32
+    assert( !pt64.is_prime( 4294967297ULL ) );  // F5 = 641 * 6700417
+    BasicMillerRabinTester<uint64_t> mr64;
+    assert( mr64.is_prime( 18446744073709551557ULL ) );
+    assert( !mr64.is_prime( 4759123141ULL ) );
+
+    std::cout << "Width test passed" << std::endl;
+}
+
+void test_wheel()
+{
+    const uint8_t spokes_30[] = { 1, 7, 11, 13, 17, 19, 23, 29 };
+    assert( Wheel<30>::n_spokes == 8 );
+    for( int i = 0; i < 8; i++ )
+    {
+        assert( Wheel<30>::spoke[ i ] == spokes_30[ i ] );
+        assert( Wheel<30>::gap[ i ] == ( i == 7 ? 31 : spokes_30[ i + 1 ] ) - spokes_30[ i ] );
+    }
+    assert( Wheel<210>::n_spokes == 48 );
+    unsigned turn = 0;
+    for( unsigned i = 0; i < 48; i++ ) turn += Wheel<210>::gap[ i ];
+    assert( turn == 210 );
+
+    PrimeTester pt;
+    BasicWheelTester<prime_t, 30> w30;
+    WheelTester w210;
+    for( prime_t m = 2; m < 200000; m++ )
+    {
+        bool p = pt.is_prime( m );
+        assert( w30.is_prime( m ) == p );
+        assert( w210.is_prime( m ) == p );
+        if( p ) assert( w210.k == w210.k_max + 1 );
+    }
+
+    // k_max should be exactly the number of divisors we try
+    uint32_t large_prime[] = { 15485863, 86028121, 472882027, 715225739, 982451653, 4294967291UL };
+    for( int i = 0; i < 6; i++ )
+    {
+        assert( w210.is_prime( large_prime[ i ] ) );
+        prime_t s = isqrt( large_prime[ i ] ), n = 0;
+        for( prime_t d = 11; d <= s; d++ )
+            if( d % 2 && d % 3 && d % 5 && d % 7 ) n++;
+        assert( w210.k_max == n );
+        assert( w210.k == n + 1 );
+        assert( w210.divisions == 4 + n );
+    }
+
+    // divisions counts the % actually done, so cheap numbers stay cheap
+    pt.is_prime( 3 ); assert( pt.divisions == 0 );
+    pt.is_prime( 1000 ); assert( pt.divisions == 1 );
+    pt.is_prime( 999 ); assert( pt.divisions == 2 );
+    pt.is_prime( 25 ); assert( pt.divisions == 3 );
+    pt.is_prime( 49 ); assert( pt.divisions == 4 );
+    w210.is_prime( 7 ); assert( w210.divisions == 3 );
+    w210.is_prime( 7 * 7 * 7 ); assert( w210.divisions == 4 );
+
+    BasicPrimeClock<prime_t, WheelTester> wc;
+    PrimeClock pc;
+    for( int i = 0; i < 1000; i++ )
+    {
+        pc.check_next(); wc.check_next();
+        assert( wc.fraction_tested() <= 1.0 );
+        if( wc.is_prime ) assert( wc.fraction_tested() == 1.0 );
+    }
+    assert( pc.primes_found == wc.primes_found );
+
+    std::cout << "Wheel test passed" << std::endl;
+}
+
+template <typename ClockA, typename ClockB>
+void assert_same_clock( const ClockA& a, const ClockB& b )
+{
+    assert( a.m == b.m );
+    assert( a.last_prime == b.last_prime );
+    assert( a.primes_found == b.primes_found );
+    assert( a.twin_primes_found == b.twin_primes_found );
+    assert( a.palindromic_primes_found == b.palindromic_primes_found );
+    for( int i = 0; i < 4; i++ )
+        for( int j = 0; j < 4; j++ )
+            assert( a.rloks[ i ][ j ] == b.rloks[ i ][ j ] );
+    assert( a.is_prime == b.is_prime );
+    if( a.is_prime )
+    {
+        assert( a.is_twin_prime == b.is_twin_prime );
+        assert( a.is_palindromic_prime == b.is_palindromic_prime );
+        assert( strcmp( a.m_as_string(), b.m_as_string() ) == 0 );
+    }
+}
+
+void test_scanner()
+{
+    scanner::WorkStealingPool pool( 4 );
+
+    // Odd chunk sizes so the seams fall all over the place, including
+    // between twin primes
+    prime_t chunks[] = { 7, 1000, 10007 };
+    for( int c = 0; c < 3; c++ )
+    {
+        PrimeClock pc, sc;
+        for( prime_t m_end : { 3, 10, 1000, 200000, 200003 } )
+        {
+            while( pc.m < m_end ) pc.check_next();
+            scanner::scan_to( sc, m_end, pool, chunks[ c ] );
+            assert_same_clock( pc, sc );
+        }
+    }
+
+    // Picking up from a restarted clock
+    PrimeClock pc, sc;
+    pc.restart_clock_from( 1000000 );
+    sc.restart_clock_from( 1000000 );
+    while( pc.m < 1500000 ) pc.check_next();
+    scanner::scan_to( sc, (prime_t) 1500000, pool );
+    assert_same_clock( pc, sc );
+
+    std::cout << "Scanner test passed" << std::endl;
+}
+
+PrimeStats stats_for( prime_t lo, prime_t hi )
+{
+    PrimeTester pt;
+    PrimeStats s( lo, hi );
+    for( prime_t m = lo; m <= hi; m++ )
+        if( pt.is_prime( m ) ) s.add_prime( m );
+    return s;
+}
+
+void test_stats_merge()
+{
+    // Cut [2, 20000] at a few awkward places: inside twin pairs, on primes,
+    // in stretches with no primes at all
+    prime_t cuts[] = { 1, 2, 3, 4, 5, 6, 11, 12, 13, 114, 120, 127, 4000, 9999, 20000 };
+    const int n_cuts = 15;
+    PrimeStats pieces[ n_cuts - 1 ];
+    for( int i = 0; i < n_cuts - 1; i++ ) pieces[ i ] = stats_for( cuts[ i ] + 1, cuts[ i + 1 ] );
+
+    // Left fold
+    PrimeStats left;
+    for( int i = 0; i < n_cuts - 1; i++ ) left.merge( pieces[ i ] );
+
+    // Right fold, to check associativity
+    PrimeStats right;
+    for( int i = n_cuts - 2; i >= 0; i-- )
+    {
+        PrimeStats s = pieces[ i ];
+        s.merge( right );
+        right = s;
+    }
+
+    PrimeStats whole = stats_for( 2, 20000 );
+    const PrimeStats *all[] = { &left, &right };
+    for( int a = 0; a < 2; a++ )
+    {
+        const PrimeStats& s = *all[ a ];
+        assert( s.lo == whole.lo && s.hi == whole.hi );
+        assert( s.first_prime == 2 && s.last_prime == whole.last_prime );
+        assert( s.primes_found == whole.primes_found );
+        assert( s.twin_primes_found == whole.twin_primes_found );
+        assert( s.palindromic_primes_found == whole.palindromic_primes_found );
+        assert( s.last_is_twin == whole.last_is_twin );
+        for( int i = 0; i < 4; i++ )
+            for( int j = 0; j < 4; j++ )
+                assert( s.rloks[ i ][ j ] == whole.rloks[ i ][ j ] );
+    }
+
+    // Identity
+    PrimeStats e, s = whole;
+    s.merge( e );
+    e.merge( whole );
+    assert( s.primes_found == whole.primes_found && e.primes_found == whole.primes_found );
+
+    // A clock that absorbs the pieces should match one that stepped
+    PrimeClock pc, ac;
+    while( pc.m < 20000 ) pc.check_next();
+    for( int i = 0; i < n_cuts - 1; i++ ) ac.absorb( pieces[ i ] );
+    assert_same_clock( pc, ac );
+
+    // and so should one that absorbs the reduction
+    PrimeClock rc;
+    rc.absorb( left );
+    assert_same_clock( pc, rc );
+
+    std::cout << "Stats merge test passed" << std::endl;
+}
+
+void test_prefilter()
+{
+    assert( inverse_mod_2w<uint32_t>( 3 ) * 3 == 1 );
+    assert( inverse_mod_2w<uint64_t>( 251 ) * 251 == 1 );
+    assert( (uint128_t) ( inverse_mod_2w<uint128_t>( 13 ) * 13 ) == 1 );
+
+    const uint16_t n = 1000;
+    uint32_t m[ n ];
+    uint8_t small[ n ];
+    uint32_t starts[] = { 0, 65000, 4294967295UL - n + 1 };
+    for( int s = 0; s < 3; s++ )
+    {
+        for( uint16_t i = 0; i < n; i++ ) m[ i ] = starts[ s ] + i;
+        small_factor_batch( m, n - 3, small );  // Odd length, to exercise the scalar tail
+        for( uint16_t i = 0; i < n - 3; i++ )
+        {
+            bool expected = false;
+            for( uint32_t p = 2; p <= max_small_prime; p++ )
+                if( m[ i ] % p == 0 && PrimeTester().is_prime( p ) ) expected = true;
+            assert( small[ i ] == expected );
+        }
+    }
+
+    for( uint64_t m64 = 18446744073709551615ULL - 1000; m64 != 0; m64++ )
+    {
+        bool expected = false;
+        for( uint64_t p = 2; p <= max_small_prime; p++ )
+            if( m64 % p == 0 && PrimeTester().is_prime( p ) ) expected = true;
+        assert( has_small_factor( m64 ) == expected );
+    }
+
+    PrimeClock pc;
+    BasicPrimeClock<prime_t, PrefilterTester> fc;
+    for( int i = 0; i < 200000; i++ )
+    {
+        pc.check_next(); fc.check_next();
+        assert( pc.is_prime == fc.is_prime );
+        if( fc.is_prime ) assert( fc.pt.k == pc.pt.k && fc.pt.k_max == pc.pt.k_max );
+    }
+    assert_same_clock( pc, fc );
+
+    std::cout << "Prefilter test passed" << std::endl;
+}
+
+void test_residues()
+{
+    PrimeTester pt;
+
+    // A small table, so we spend most of the range in the fallback
+    BasicResidueTester<prime_t, 20> small;
+    ResidueTester *big = new ResidueTester;  // Too big for the stack
+    for( prime_t m = 2; m < 300000; m++ )
+    {
+        bool p = pt.is_prime( m );
+        assert( small.is_prime( m ) == p );
+        assert( big->is_prime( m ) == p );
+        if( p && m > 3 )
+        {
+            assert( small.k == small.k_max + 1 );
+            assert( big->k == big->k_max + 1 );
+        }
+    }
+    assert( big->n_live == 100 );  // odd primes up to sqrt(299999) = 547
+
+    // Jumps resync, then stepping carries on from there
+    prime_t starts[] = { 1000000007, 4294967295UL - 2000, 12345 };
+    for( int s = 0; s < 3; s++ )
+        for( prime_t m = starts[ s ]; m - starts[ s ] < 2000 && m >= starts[ s ]; m++ )
+        {
+            assert( big->is_prime( m ) == pt.is_prime( m ) );
+            assert( small.is_prime( m ) == pt.is_prime( m ) );
+        }
+    delete big;
+
+    // Composite bars: k points at the first prime that divides m
+    BasicResidueTester<prime_t, 20> rt;
+    for( prime_t m = 1; m <= 1001; m++ ) rt.is_prime( m );  // 1001 = 7 * 11 * 13
+    assert( rt.k == 3 && rt.k_max == 10 );  // 7 is the 3rd odd prime, 3 .. 31 are live
+
+    std::cout << "Residue test passed" << std::endl;
+}
+
+void test_prime_pi()
+{
+    // Known values
+    assert( prime_pi( (prime_t) 1 ) == 0 );
+    assert( prime_pi( (prime_t) 2 ) == 1 );
+    assert( prime_pi( (prime_t) 100 ) == 25 );
+    assert( prime_pi( (prime_t) 1000000 ) == 78498 );
+    assert( prime_pi( (prime_t) 2147483648UL ) == 105097565 );
+    assert( prime_pi( (prime_t) 4294967295UL ) == 203280221 );
+    assert( prime_pi( (uint64_t) 10000000000ULL ) == 455052511 );
+
+    // Against counting them one by one
+    PrimeClock pc;
+    for( prime_t m = 1; m < 20000; m++ )
+    {
+        assert( prime_pi( m ) == pc.primes_found );
+        pc.check_next();
+    }
+
+    // A jump carries on with the true count
+    PrimeClock jc, sc;
+    jc.restart_clock_from( 1000000 );
+    assert( jc.primes_found == 78498 && jc.last_prime == 999983 );
+    sc.restart_clock_from( 999982 );  // last_prime comes from below
+    assert( sc.last_prime == 999979 );
+    for( int i = 0; i < 1000; i++ ) { jc.check_next(); sc.check_next(); }
+    for( ; sc.m < jc.m; ) sc.check_next();
+    assert( jc.primes_found == sc.primes_found );
+    assert( jc.last_prime == sc.last_prime );
+
+    // A wide clock far out just starts counting again, and doesn't hang
+    BasicPrimeClock<uint64_t> c64;
+    c64.restart_clock_from( 1ULL << 40 );
+    assert( c64.primes_found == 0 && c64.last_prime == 1 );
+    c64.restart_clock_from( 1000000 );
+    assert( c64.primes_found == 78498 && c64.last_prime == 999983 );
+
+    std::cout << "Prime counting test passed" << std::endl;
+}
+
+void test_snapshots()
+{
+    assert( n_clock_snapshots == 25 );
+
+    // Small ones against stepping the clock
+    PrimeClock pc;
+    ClockSnapshot s;
+    for( uint8_t pow = 1; pow <= 20; pow++ )
+    {
+        prime_t m = (prime_t) 1 << pow;
+        assert( find_clock_snapshot( m, s ) == ( pow == 1 || pow >= 8 ) );
+        while( pc.m < m ) pc.check_next();
+        if( pow != 1 && pow < 8 ) continue;
+
+        PrimeClock rc;
+        rc.restore( s );
+        assert( rc.m == pc.m );
+        assert( rc.last_prime == pc.last_prime );
+        assert( rc.primes_found == pc.primes_found );
+        assert( rc.twin_primes_found == pc.twin_primes_found );
+        assert( rc.palindromic_primes_found == pc.palindromic_primes_found );
+        assert( memcmp( rc.rloks, pc.rloks, sizeof( pc.rloks ) ) == 0 );
+    }
+    assert( !find_clock_snapshot( 1000, s ) );
+
+    // The big ones at least have the right prime counts
+    for( uint8_t pow = 21; pow <= 31; pow++ )
+    {
+        assert( find_clock_snapshot( (prime_t) 1 << pow, s ) );
+        assert( s.primes_found == prime_pi( s.m ) );
+        assert( s.last_prime == prime_at_or_below( s.m ) );
+    }
+
+    // And carry on just like the stepped clock
+    PrimeClock rc;
+    find_clock_snapshot( 1 << 20, s );
+    rc.restore( s );
+    for( int i = 0; i < 10000; i++ ) { rc.check_next(); pc.check_next(); }
+    assert_same_clock( rc, pc );
+
+    // A wider clock keeps its full width through a snapshot
+    BasicClockSnapshot<uint64_t> w = {}, w2;
+    w.m = 5000000001ULL;
+    w.last_prime = 4999999937ULL;
+    w.primes_found = 234954223ULL;
+    BasicPrimeClock<uint64_t> c64;
+    c64.restore( w );
+    c64.snapshot( w2 );
+    assert( w2.m == w.m && w2.last_prime == w.last_prime && w2.primes_found == w.primes_found );
+
+    std::cout << "Snapshot test passed" << std::endl;
+}
+
+void test_archive()
+{
+    const char *path = "primes_test.archive";
+    PrimeTester pt;
+
+    // Small stride so there are plenty of checkpoints
+    {
+        archive::ArchiveWriter aw( path, 1000 );
+        assert( aw.good() );
+        PrimeClock pc;
+        while( pc.m < 3000000 )
+        {
+            pc.check_next();
+            aw.record( pc );
+        }
+        assert( aw.size() == 216816 );
+        assert( aw.close() );
+    }
+
+    archive::ArchiveReader ar;
+    assert( ar.open( path ) );
+    assert( ar.first() == 2 && ar.last() == 2999999 );
+    assert( ar.first_rank() == 1 && ar.last_rank() == 216816 );
+    assert( ar.nth_prime( 1 ) == 2 && ar.nth_prime( 2 ) == 3 );  // the escaped gap
+    assert( ar.nth_prime( 78498 ) == 999983 );
+    assert( ar.pi( 1 ) == 0 && ar.pi( 2 ) == 1 );
+    for( prime_t m = 2; m < 3000000; m++ )
+    {
+        assert( ar.is_prime( m ) == pt.is_prime( m ) );
+        if( m % 997 == 0 ) assert( ar.pi( m ) == prime_pi( m ) );
+    }
+    for( uint64_t n = 1; n <= ar.last_rank(); n += 101 )
+        assert( ar.pi( ar.nth_prime( n ) ) == n );
+
+    // Started after a jump, the ranks are still the true ones
+    {
+        archive::ArchiveWriter aw( path );
+        PrimeClock pc;
+        pc.restart_clock_from( 1000000000 );
+        while( pc.m < 1001000000 )
+        {
+            pc.check_next();
+            aw.record( pc );
+        }
+    }
+    assert( ar.open( path ) );
+    assert( ar.first_rank() == prime_pi( (prime_t) 1000000000 ) + 1 );
+    assert( ar.pi( 1000500000 ) == prime_pi( (prime_t) 1000500000 ) );
+    assert( ar.nth_prime( ar.first_rank() ) == 1000000007 );
+
+    // Outside the archive there is no answer
+    assert( !ar.covers( 0 ) && !ar.is_prime( 0 ) && !ar.is_prime( 7 ) );
+    assert( ar.pi( 7 ) == 0 && ar.pi( ar.last() + 1 ) == 0 );
+    assert( !ar.covers( 1001000003 ) && !ar.is_prime( 1001000003 ) );
+    assert( ar.nth_prime( 1 ) == 0 && ar.nth_prime( ar.last_rank() + 1 ) == 0 );
+    assert( ar.covers( ar.last() ) && ar.is_prime( ar.last() ) );
+    ar.close();
+
+    // A writer that could not write says so
+    {
+        archive::ArchiveWriter aw( "/dev/full" );
+        for( uint64_t p = 3; p < 100000; p += 2 ) aw.add( p );
+        assert( !aw.close() );
+    }
+
+    assert( !ar.open( "primes_test.no_such_archive" ) );
+    std::remove( path );
+
+    std::cout << "Archive test passed" << std::endl;
+}
+
+void test_checkpoint()
+{
+    using namespace checkpoint;
+    const char *path = "primes_test.checkpoint";
+    std::remove( path );
+
+    PrimeClock pc;
+    ClockSnapshot s;
+    Checkpointer cp( ( FileStorage( path ) ) );
+    assert( !cp.load( s ) );  // Nothing saved yet
+
+    for( int i = 0; i < 5; i++ )
+    {
+        for( int j = 0; j < 10000; j++ ) pc.check_next();
+        pc.snapshot( s );
+        assert( cp.save( s ) );
+    }
+
+    // A fresh start resumes where we were
+    {
+        Checkpointer cp2( ( FileStorage( path ) ) );
+        PrimeClock rc;
+        assert( cp2.load( s ) );
+        rc.restore( s );
+        assert( cp2.seq == 5 );
+        for( int j = 0; j < 1000; j++ ) { rc.check_next(); pc.check_next(); }
+        assert_same_clock( rc, pc );
+    }
+
+    // Tear the next write: we fall back to the previous good record
+    pc.snapshot( s );
+    CheckpointRecord r;
+    r.seq = cp.seq + 1;
+    r.state = s;
+    r.crc = record_crc( r );
+    r.state.primes_found++;  // as if the power went half way through
+    FileStorage( path ).write( cp.next_slot * sizeof( r ), &r, sizeof( r ) );
+    {
+        Checkpointer cp2( ( FileStorage( path ) ) );
+        assert( cp2.load( s ) );
+        assert( cp2.seq == 5 && s.m == 50001 );
+        assert( cp2.next_slot == cp.next_slot );  // the torn slot gets rewritten
+    }
+
+    // seq wrapping round still picks the newer one
+    Checkpointer cw( ( FileStorage( path ) ) );
+    cw.seq = 0xfffffffe;
+    s.m = 1; cw.save( s );
+    s.m = 2; cw.save( s );  // seq 0
+    assert( cw.seq == 0 );
+    assert( cw.load( s ) && s.m == 2 );
+
+    std::remove( path );
+    std::cout << "Checkpoint test passed" << std::endl;
+}
+
+void test_check_range()
+{
+    PrimeClock pc, bc;
+    CheckBlock b;
+    int n_blocks = 0;
+    while( bc.m < 200000 )
+    {
+        // Odd sizes too, and asking for more than fits
+        uint16_t n = bc.check_range( b, n_blocks % 3 ? 16 : 7 + n_blocks % 20 );
+        assert( n == b.n && n <= 16 );
+        for( uint16_t i = 0; i < n; i++ )
+        {
+            pc.check_next();
+            assert( b.m[ i ] == pc.m );
+            assert( ( b.flags[ i ] & flag_prime ) == ( pc.is_prime ? flag_prime : 0 ) );
+            if( pc.is_prime )
+            {
+                assert( !!( b.flags[ i ] & flag_twin_prime ) == pc.is_twin_prime );
+                assert( !!( b.flags[ i ] & flag_palindromic_prime ) == pc.is_palindromic_prime );
+            }
+            assert( b.f16[ i ] == pc.fraction_tested_q16() );
+        }
+        assert_same_clock( bc, pc );
+        n_blocks++;
+    }
+
+    std::cout << "Check range test passed" << std::endl;
+}
+
+void test_q16()
+{
+    // Against 64 bit arithmetic
+    uint32_t dens[] = { 1, 2, 3, 7, 1000, 65535, 65536, 65537, 10922, 4294967295UL };
+    for( uint32_t den : dens )
+        for( uint32_t i = 0; i <= 1000; i++ )
+        {
+            uint32_t num = (uint64_t) den * i / 1000;
+            assert( q16_ratio( num, den ) == ( (uint64_t) num << 16 ) / den );
+        }
+    assert( q16_ratio( 5u, 3u ) == q16_one );
+
+    // The clock's progress, including the aborted and finished cases
+    PrimeClock pc;
+    pc.restart_clock_from( 1000000000 );
+    for( int i = 0; i < 1000; i++ )
+    {
+        pc.check_next();
+        uint32_t f16 = pc.fraction_tested_q16();
+        if( pc.pt.k > pc.pt.k_max ) assert( f16 == q16_one );
+        else assert( f16 == ( (uint64_t) ( pc.pt.k - 1 ) << 16 ) / pc.pt.k_max );
+    }
+    pc.pt.k = 0;
+    assert( pc.fraction_tested_q16() == 0 );
+
+    std::cout << "Q16 test passed" << std::endl;
+}
+
+void test_resumable()
+{
+    PrimeTester pt, rt;
+
+    // Slices of any size give the same answers, and k moves on between them
+    prime_t starts[] = { 2, 1000000000, 4294967295UL - 3000 };
+    for( prime_t budget : { 1u, 7u, 1000u } )
+        for( prime_t s : starts )
+            for( prime_t m = s; m - s < 3000 && m >= s; m++ )
+            {
+                rt.start( m );
+                prime_t last_k = rt.k;
+                while( !rt.resume( budget ) )
+                {
+                    assert( rt.k == last_k + budget );
+                    last_k = rt.k;
+                }
+                assert( rt.verdict == pt.is_prime( m ) );
+                assert( rt.k == pt.k && rt.k_max == pt.k_max );
+            }
+
+    // start() with the m in progress carries on, another m starts over
+    rt.start( 4294967291UL );
+    rt.resume( 100 );
+    assert( rt.k == 101 );
+    rt.start( 4294967291UL );
+    assert( rt.k == 101 );
+    rt.start( 4294967279UL );
+    assert( rt.k == 1 );
+
+    // Aborting ends the test cleanly
+    rt.resume( 10 );
+    rt.abrt = true;
+    assert( rt.resume( 10 ) && !rt.verdict && rt.k == 0 && !rt.running );
+    rt.start( 4294967279UL );  // and the same m can be run again
+    while( !rt.resume( 1000 ) );
+    assert( rt.verdict );
+
+    // The clock in slices matches check_next()
+    PrimeClock pc, sc;
+    pc.restart_clock_from( 999000000 );
+    sc.restart_clock_from( 999000000 );
+    for( int i = 0; i < 2000; i++ )
+    {
+        pc.check_next();
+        sc.start_next();
+        while( !sc.resume_next( 50 ) );
+        assert_same_clock( pc, sc );
+    }
+
+    // A restart while we are part way through drops that number
+    sc.start_next();
+    sc.resume_next( 1 );
+    sc.restart_clock_from( 1000 );
+    assert( sc.resume_next( 1 ) && !sc.is_prime );
+    sc.start_next();
+    while( !sc.resume_next( 1 ) );
+    assert( sc.m == 1001 && !sc.is_prime );
+
+    std::cout << "Resumable tester test passed" << std::endl;
+}
+
+// The sliced path gives the same clock as check_next(), whatever the tester
+template <typename Tester>
+void check_sliced( prime_t from, int n )
+{
+    BasicPrimeClock<prime_t, Tester> pc, sc;
+    pc.restart_clock_from( from );
+    sc.restart_clock_from( from );
+    for( int i = 0; i < n; i++ )
+    {
+        pc.check_next();
+        sc.start_next();
+        while( !sc.resume_next( 3 ) );
+        assert_same_clock( pc, sc );
+        assert( pc.pt.k == sc.pt.k && pc.pt.k_max == sc.pt.k_max );
+    }
+}
+
+void test_sliced_testers()
+{
+    for( prime_t from : { (prime_t) 1, (prime_t) 1000000 } )
+    {
+        check_sliced<PrimeTester>( from, 3000 );
+        check_sliced<WheelTester>( from, 3000 );
+        check_sliced<ResidueTester>( from, 3000 );
+        check_sliced<MillerRabinTester>( from, 3000 );
+        check_sliced<SieveTester>( from, 3000 );
+        check_sliced<PrefilterTester>( from, 3000 );
+        check_sliced< BasicPrefilterTester<prime_t, WheelTester> >( from, 3000 );
+#if __cplusplus >= 201402L
+        check_sliced<SmallPrimeTester>( from, 3000 );
+#endif
+    }
+
+    // The prefilter rejects on the sliced path too, without trial division
+    PrefilterTester pt;
+    pt.start( 251UL * 4001 );
+    assert( pt.resume( 1 ) && !pt.verdict && pt.k == 1 );
+
+    std::cout << "Sliced testers test passed" << std::endl;
+}
+
+void test_seqlock()
+{
+    // A write under way is never read
+    SeqLock<ClockProgress> l;
+    ClockProgress p = { 10, 2, 3 }, q;
+    l.publish( p );
+    assert( l.version() == 2 && l.try_read( q ) && q.m == 10 && q.k == 2 && q.k_max == 3 );
+    l.seq++;
+    assert( !l.try_read( q ) );
+    l.seq++;
+
+    // A wider clock publishes at its full width
+    SeqLock< BasicClockProgress<uint64_t> > wide;
+    BasicClockProgress<uint64_t> w;
+    BasicPrimeClock<uint64_t> c64;
+    c64.progress_out = &wide;
+    c64.m = 5000000028ULL;  // so the next one is a prime
+    c64.start_next();
+    c64.resume_next( 10 );
+    wide.read( w );
+    assert( w.m == 5000000029ULL && w.k == 11 && w.k_max == ( isqrt( 5000000029ULL ) + 1 ) / 6 );
+
+    // Readers on other threads only ever see what the clock published, whole
+    const prime_t start = 4294000000UL;
+    const int n = 20000;
+    std::vector<ClockSnapshot> history( n + 1 );
+    PrimeClock ref;
+    ref.restart_clock_from( start );
+    for( int i = 0; i <= n; i++ )
+    {
+        ref.snapshot( history[ i ] );
+        ref.check_next();
+    }
+
+    SeqLock<ClockProgress> progress;
+    SeqLock<ClockSnapshot> stats;
+    std::atomic<bool> done( false );
+    std::atomic<uint64_t> stats_reads( 0 ), progress_reads( 0 );
+
+    auto read_stats = [ & ]
+    {
+        ClockSnapshot c;
+        while( !done )
+        {
+            if( !stats.try_read( c ) || stats.version() == 0 ) continue;
+            assert( c.m >= start && c.m - start <= (prime_t) n );
+            assert( memcmp( &c, &history[ c.m - start ], sizeof( c ) ) == 0 );
+            stats_reads++;
+        }
+    };
+    auto read_progress = [ & ]
+    {
+        ClockProgress c;
+        while( !done )
+        {
+            if( !progress.try_read( c ) || progress.version() == 0 ) continue;
+            assert( c.m >= start && c.m - start <= (prime_t) n );
+            if( c.m % 2 && c.m % 3 )  // k_max belongs to m
+                assert( c.k_max == ( isqrt( c.m ) + 1 ) / 6 );
+            assert( c.k <= c.k_max + 1 );
+            assert( c.fraction_tested_q16() <= q16_one );
+            progress_reads++;
+        }
+    };
+    std::thread readers[] = { std::thread( read_stats ), std::thread( read_stats ),
+                              std::thread( read_progress ) };
+
+    PrimeClock pc;
+    pc.progress_out = &progress;
+    pc.stats_out = &stats;
+    pc.restart_clock_from( start );
+    for( int i = 0; i < n; i++ )
+    {
+        pc.start_next();
+        while( !pc.resume_next( 50 ) );
+    }
+    done = true;
+    for( auto& t : readers ) t.join();
+
+    ClockSnapshot last;
+    stats.read( last );
+    assert( memcmp( &last, &history[ n ], sizeof( last ) ) == 0 );
+    assert( stats.version() == 2 * ( n + 1 ) );
+    assert( stats_reads > 0 && progress_reads > 0 );
+
+    std::cout << "Seqlock test passed" << std::endl;
+}
+
+// Keeps everything it is shown
+struct LogSink
+{
+    std::vector<pipeline::NumberRecord> records;
+    ClockSnapshot last_stats;
+    int sleep_us = 0;
+
+    void show( const pipeline::NumberRecord* r, size_t n, const ClockSnapshot& s )
+    {
+        records.insert( records.end(), r, r + n );
+        last_stats = s;
+        if( sleep_us ) std::this_thread::sleep_for( std::chrono::microseconds( sleep_us ) );
+    }
+};
+
+void test_pipeline()
+{
+    using namespace pipeline;
+
+    // The ring hands over everything, in order, across threads
+    SpscRing<uint64_t, 64> ring;
+    const uint64_t n = 1000000;
+    std::thread producer( [ & ]
+    {
+        for( uint64_t i = 0; i < n; i++ )
+            while( !ring.try_push( i ) ) std::this_thread::yield();
+    } );
+    uint64_t expected = 0, x, buf[ 16 ];
+    while( expected < n )
+    {
+        size_t got = 0;
+        if( expected % 3 == 0 )
+        {
+            if( ring.try_pop( x ) ) { assert( x == expected++ ); got = 1; }
+        }
+        else
+        {
+            got = ring.pop_all( buf, 16 );
+            for( size_t i = 0; i < got; i++ ) assert( buf[ i ] == expected++ );
+        }
+        if( !got ) std::this_thread::yield();
+    }
+    producer.join();
+    assert( ring.size() == 0 && !ring.try_pop( x ) );
+
+    // A full ring makes room by losing its oldest
+    SpscRing<uint64_t, 4> small;
+    for( uint64_t i = 0; i < 6; i++ ) assert( small.push_overwrite( i ) == ( i < 4 ) );
+    assert( small.size() == 4 && small.pop_all( buf, 16 ) == 4 );
+    for( uint64_t i = 0; i < 4; i++ ) assert( buf[ i ] == i + 2 );
+
+    // and while the consumer is taking items out it only ever gets whole,
+    // newer ones, and the newest at the end
+    struct Pair { uint64_t i, not_i; };
+    SpscRing<Pair, 4> pairs;
+    std::thread overwriter( [ & ]
+    {
+        for( uint64_t i = 0; i < n; i++ )
+        {
+            pairs.push_overwrite( Pair{ i, ~i } );
+            if( i % 64 == 0 ) std::this_thread::yield();
+        }
+    } );
+    Pair got_pairs[ 3 ];
+    for( uint64_t newest = 0; newest != n - 1; )
+    {
+        size_t got = pairs.pop_all( got_pairs, 3 );
+        for( size_t i = 0; i < got; i++ )
+        {
+            assert( got_pairs[ i ].not_i == ~got_pairs[ i ].i );
+            assert( newest == 0 || got_pairs[ i ].i > newest );
+            newest = got_pairs[ i ].i;
+        }
+        if( !got ) std::this_thread::yield();
+    }
+    overwriter.join();
+
+    // A fast sink sees every number, as the clock saw it
+    LogSink log;
+    {
+        Pipeline<LogSink> p( log );
+        p.start( 1000000 );
+        while( p.produced < 50000 ) std::this_thread::yield();
+        p.stop();
+        assert( p.produced == p.shown + p.dropped + p.coalesced );
+    }
+    PrimeClock ref;
+    ref.restart_clock_from( 1000000 );
+    PrimeClock view;
+    for( size_t i = 1; i < log.records.size(); i++ )
+        assert( log.records[ i ].m > log.records[ i - 1 ].m );
+    for( const auto& r : log.records )
+    {
+        if( r.m - log.records[ 0 ].m > 20000 ) break;
+        while( ref.m < r.m ) ref.check_next();
+        NumberRecord e = record_of( ref );
+        assert( e.m == r.m && e.f16 == r.f16 && e.flags == r.flags );
+        show_on( view, r, log.last_stats );
+        assert( view.fraction_tested_q16() == r.f16 && view.is_prime == ref.is_prime );
+    }
+    const NumberRecord& last = log.records.back();
+    assert( log.last_stats.m == last.m );
+
+    // A slow sink doesn't hold the engine back: it gets coalesced batches,
+    // the engine drops the oldest of what doesn't fit, and the last number
+    // tested is still the last one shown
+    LogSink slow;
+    slow.sleep_us = 2000;
+    {
+        Pipeline<LogSink, 1024> p( slow, 250 );
+        p.start( 1000000 );
+        std::this_thread::sleep_for( std::chrono::milliseconds( 100 ) );
+        p.stop();
+        assert( p.produced == p.shown + p.dropped + p.coalesced );
+        assert( p.dropped + p.coalesced > 0 && p.shown <= 250 * p.batches );
+    }
+    for( size_t i = 1; i < slow.records.size(); i++ )
+        assert( slow.records[ i ].m > slow.records[ i - 1 ].m );
+    assert( slow.last_stats.m == slow.records.back().m );
+
+    std::cout << "Pipeline test passed" << std::endl;
+}
+
+#if __cplusplus >= 201402L
+void test_small_primes()
+{
+    PrimeTester pt;
+    SmallPrimeTester st;
+
+    assert( st.n_small_primes_upto( 65535 ) == n_table_odd_primes );
+    assert( st.n_small_primes_upto( 100 ) == 24 );
+    assert( st.n_small_primes_upto( 2 ) == 0 );
+
+    prime_t starts[] = { 2, 1000000007, 4294967295UL - 5000 };
+    for( int s = 0; s < 3; s++ )
+        for( prime_t m = starts[ s ]; m - starts[ s ] < 200000 && m >= starts[ s ]; m++ )
+        {
+            bool p = pt.is_prime( m );
+            assert( st.is_prime( m ) == p );
+            if( p ) assert( st.k == st.k_max + 1 );
+        }
+
+    // 25 and 49 are not divisors any more: 4294967291 is prime and
+    // sqrt is 65535, so we should divide by every odd prime below that
+    assert( st.is_prime( 4294967291UL ) );
+    assert( st.k_max == n_table_odd_primes );
+
+    // Past the table for 64 bit m: 65537^2 has to be caught by the fallback
+    BasicSmallPrimeTester<uint64_t> st64;
+    assert( !st64.is_prime( 65537ULL * 65537ULL ) );
+    assert( st64.k == n_table_odd_primes + 1 );
+    assert( st64.is_prime( 4294967311ULL ) );  // first prime past 2^32
+
+    // Composite bars: 1001 = 7 * 11 * 13, 7 is the 3rd odd prime
+    st.is_prime( 1001 );
+    assert( st.k == 3 && st.k_max == 10 );
+
+    std::cout << "Small prime test passed" << std::endl;
+}
+#endif
+
 int main()
 {
     test_digits();
     test_primes();
     test_rloks();
     test_large_primes(); 
+    test_sieve();
+    test_miller_rabin();
+    test_widths();
+    test_wheel();
+    test_scanner();
+    test_stats_merge();
+    test_prefilter();
+    test_residues();
+    test_prime_pi();
+    test_snapshots();
+    test_archive();
+    test_checkpoint();
+    test_check_range();
+    test_q16();
+    test_resumable();
+    test_sliced_testers();
+    test_seqlock();
+    test_pipeline();
+#if __cplusplus >= 201402L
+    test_small_primes();
+#endif
 }
\ No newline at end of file
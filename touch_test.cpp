@@ -0,0 +1,134 @@
+// Tests for the touch screen debouncing, fed scripted points
+
+// g++ -std=c++14 -Ihost touch_test.cpp -o tt
+
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+#include "moulick/debounce.h"
+
+using namespace debounce;
+
+struct Sample
+{
+  unsigned long t;
+  int16_t x, y, z;
+};
+
+// Runs the script through a debouncer and returns the taps
+std::vector<TouchEvent> play( const std::vector<Sample>& script )
+{
+  TouchDebouncer d;
+  EventQueue<TouchEvent, 8> q;
+  for( const auto& s : script )
+    if( d.update( TSPoint( s.x, s.y, s.z ), s.t ) ) assert( q.push( d.event ) );
+  std::vector<TouchEvent> taps;
+  TouchEvent e;
+  while( q.pop( e ) ) taps.push_back( e );
+  return taps;
+}
+
+// A steady press from t0 to t1, one sample every dt
+void press( std::vector<Sample>& script, unsigned long t0, unsigned long t1, int16_t x, int16_t y,
+            unsigned long dt = 10 )
+{
+  for( unsigned long t = t0; t < t1; t += dt ) script.push_back( { t, x, y, 300 } );
+}
+
+void idle( std::vector<Sample>& script, unsigned long t0, unsigned long t1, unsigned long dt = 10 )
+{
+  for( unsigned long t = t0; t < t1; t += dt ) script.push_back( { t, 0, 0, 0 } );
+}
+
+void test_debouncer()
+{
+  // A clean tap is one event, where the touch settled
+  std::vector<Sample> s;
+  idle( s, 0, 100 );
+  press( s, 100, 400, 50, 200 );
+  idle( s, 400, 1000 );
+  auto taps = play( s );
+  assert( taps.size() == 1 );
+  assert( taps[ 0 ].p.x == 50 && taps[ 0 ].p.y == 200 && taps[ 0 ].t == 100 + DEBOUNCE_MS );
+
+  // A blip shorter than DEBOUNCE_MS is noise
+  s.clear();
+  press( s, 0, DEBOUNCE_MS - 10, 50, 200 );
+  idle( s, DEBOUNCE_MS - 10, 500 );
+  assert( play( s ).empty() );
+
+  // Out of range pressure doesn't count as a touch
+  s.clear();
+  for( unsigned long t = 0; t < 500; t += 10 ) s.push_back( { t, 50, 200, MAXPRESSURE + 1 } );
+  assert( play( s ).empty() );
+
+  // Drop outs while held, and bouncing as the stylus comes up, are still
+  // the one tap
+  s.clear();
+  press( s, 0, 200, 50, 200 );
+  for( unsigned long t = 200; t < 1000; t += 40 )
+  {
+    idle( s, t, t + 20 );
+    press( s, t + 20, t + 40, 50, 200 );
+  }
+  idle( s, 1000, 1500 );
+  assert( play( s ).size() == 1 );
+
+  // Two taps with a proper gap are two
+  s.clear();
+  press( s, 0, 200, 10, 100 );
+  idle( s, 200, 200 + RELEASE_MS + 10 );
+  press( s, 200 + RELEASE_MS + 10, 600, 10, 250 );
+  idle( s, 600, 1000 );
+  taps = play( s );
+  assert( taps.size() == 2 && taps[ 0 ].p.y == 100 && taps[ 1 ].p.y == 250 );
+
+  // Slow sampling (the app's frame rate) still sees the tap
+  s.clear();
+  press( s, 0, 300, 10, 100, 62 );
+  idle( s, 300, 800, 62 );
+  assert( play( s ).size() == 1 );
+
+  // millis() wrapping around mid touch
+  s.clear();
+  unsigned long t0 = (unsigned long) -25;
+  for( unsigned long i = 0; i < 20; i++ ) s.push_back( { t0 + i * 10, 10, 100, 300 } );
+  assert( play( s ).size() == 1 );
+
+  std::cout << "Debouncer test passed" << std::endl;
+}
+
+void test_event_queue()
+{
+  EventQueue<int, 4> q;
+  int e;
+  assert( q.empty() && !q.pop( e ) );
+
+  // Holds N - 1, drops the rest
+  assert( q.push( 1 ) && q.push( 2 ) && q.push( 3 ) );
+  assert( !q.push( 4 ) );
+  assert( q.pop( e ) && e == 1 );
+  assert( q.push( 5 ) );
+
+  // In order, across the wrap around
+  while( q.pop( e ) );
+  int next_in = 0, next_out = 0;
+  for( int i = 0; i < 100; i++ )
+  {
+    while( q.push( next_in ) ) next_in++;
+    assert( next_in - next_out == 3 );
+    for( int j = 0; j <= i % 3; j++ )
+      assert( q.pop( e ) && e == next_out++ );
+  }
+  while( q.pop( e ) ) assert( e == next_out++ );
+  assert( q.empty() && next_out == next_in );
+
+  std::cout << "Event queue test passed" << std::endl;
+}
+
+int main()
+{
+  test_debouncer();
+  test_event_queue();
+}